@@ -0,0 +1,168 @@
+#include "batch.h"
+#include "infra.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <charconv>
+#include <thread>
+
+// Queries per thread below which starting another thread doesn't pay off.
+static const size_t MIN_CHUNK = 256;
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+static void append_json_string(std::string* out, std::string_view s) {
+    *out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            *out += '\\';
+            *out += c;
+        } else if ((unsigned char)c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            *out += "\\u00";
+            *out += hex[(c >> 4) & 0xf];
+            *out += hex[c & 0xf];
+        } else {
+            *out += c;
+        }
+    }
+    *out += '"';
+}
+
+static void append_number(std::string* out, int64_t value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out->append(buf, res.ptr - buf);
+}
+
+static void format_found(std::string* out, const BlockTable& chain, std::string_view query, size_t i,
+                         BatchFormat format) {
+    if (format == BATCH_JSON) {
+        *out += "{\"query\":";
+        append_json_string(out, query);
+        *out += ",\"found\":true,\"hash\":\"";
+        *out += chain.hash_hex(i);
+        *out += "\",\"height\":";
+        append_number(out, chain.height(i));
+        *out += ",\"total\":";
+        append_number(out, chain.total(i));
+        *out += ",\"time\":\"";
+        *out += chain.time_iso(i);
+        *out += "\",\"relayed_by\":";
+        append_json_string(out, chain.relayed_by(i));
+        *out += ",\"prev_block\":\"";
+        *out += chain.prev_block_hex(i);
+        *out += "\"}\n";
+        return;
+    }
+    *out += "hash: ";
+    *out += chain.hash_hex(i);
+    *out += "\nheight: ";
+    append_number(out, chain.height(i));
+    *out += "\ntotal: ";
+    append_number(out, chain.total(i));
+    *out += "\ntime: ";
+    *out += chain.time_iso(i);
+    *out += "\nrelayed_by: ";
+    *out += chain.relayed_by(i);
+    *out += "\nprev_block: ";
+    *out += chain.prev_block_hex(i);
+    *out += "\n\n";
+}
+
+static void format_missing(std::string* out, std::string_view query, bool is_height, bool valid,
+                           BatchFormat format) {
+    if (format == BATCH_JSON) {
+        *out += "{\"query\":";
+        append_json_string(out, query);
+        *out += valid ? ",\"found\":false}\n" : ",\"found\":false,\"error\":\"invalid query\"}\n";
+        return;
+    }
+    if (!valid) {
+        *out += "Invalid query '";
+        *out += query;
+        *out += "'.\n\n";
+        return;
+    }
+    *out += is_height ? "Block with height '" : "Block with hash '";
+    *out += query;
+    *out += "' not found.\n\n";
+}
+
+static void resolve_chunk(const ChainSnapshot* snap, const std::string_view* queries, size_t count,
+                          BatchFormat format, std::string* out, BatchStats* stats) {
+    for (size_t q = 0; q < count; ++q) {
+        std::string_view query = trim(queries[q]);
+        std::string_view key = query;
+        bool is_height;
+        if (key.compare(0, 8, "--height") == 0) {
+            key = trim(key.substr(8));
+            is_height = true;
+        } else if (key.compare(0, 6, "--hash") == 0) {
+            key = trim(key.substr(6));
+            is_height = false;
+        } else {
+            is_height = key.size() < 64;
+        }
+
+        size_t row = 0;
+        bool valid = true, found = false;
+        if (is_height) {
+            int height = 0;
+            auto res = std::from_chars(key.data(), key.data() + key.size(), height);
+            valid = !key.empty() && res.ec == std::errc() && res.ptr == key.data() + key.size();
+            found = valid && snap->find_height(height, &row);
+        } else {
+            valid = key.size() == 64;
+            found = valid && snap->find_hash(key, &row);
+        }
+
+        ++stats->queries;
+        if (found) {
+            ++stats->found;
+            format_found(out, snap->table(), key, row, format);
+        } else {
+            if (!valid) ++stats->invalid;
+            format_missing(out, key, is_height, valid, format);
+        }
+    }
+}
+
+void resolve_batch(const std::vector<std::string_view>& queries, BatchFormat format, int threads,
+                   std::string* out, BatchStats* stats) {
+    // One snapshot for the whole batch, so a reload can't change the chain
+    // between the lookup and the formatting.
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    size_t n = queries.size();
+    size_t workers = threads < 1 ? 1 : (size_t)threads;
+    workers = std::min(workers, std::max<size_t>(1, n / MIN_CHUNK));
+
+    std::vector<std::string> buffers(workers);
+    std::vector<BatchStats> partial(workers);
+    std::vector<std::thread> pool;
+    size_t per = (n + workers - 1) / workers;
+    for (size_t w = 0; w < workers; ++w) {
+        size_t first = std::min(n, w * per);
+        size_t count = std::min(n, first + per) - first;
+        buffers[w].reserve(count * 400);
+        if (w + 1 == workers) {
+            resolve_chunk(snap.get(), queries.data() + first, count, format, &buffers[w], &partial[w]);
+        } else {
+            pool.emplace_back(resolve_chunk, snap.get(), queries.data() + first, count, format, &buffers[w],
+                              &partial[w]);
+        }
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    for (size_t w = 0; w < workers; ++w) {
+        *out += buffers[w];
+        stats->queries += partial[w].queries;
+        stats->found += partial[w].found;
+        stats->invalid += partial[w].invalid;
+    }
+}
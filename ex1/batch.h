@@ -0,0 +1,32 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Batch lookups against the loaded chain (ex2.out --batch).
+//
+// Each query is a block height (all digits) or a 64-character hex hash,
+// optionally prefixed with --height / --hash like the single-query form.
+// Queries are split into contiguous chunks resolved on separate threads;
+// every thread formats its results into its own buffer, and the buffers
+// are joined in input order, so output order never depends on scheduling.
+
+enum BatchFormat {
+    BATCH_TEXT,    // same lines as the single-query output, blank line between results
+    BATCH_JSON,    // one JSON object per line
+};
+
+struct BatchStats {
+    size_t queries = 0;
+    size_t found = 0;
+    size_t invalid = 0;
+};
+
+// Resolves `queries` and appends the formatted results to `out`.
+void resolve_batch(const std::vector<std::string_view>& queries, BatchFormat format, int threads,
+                   std::string* out, BatchStats* stats);
+
+#endif // BATCH_H
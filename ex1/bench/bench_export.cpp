@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include "infra.h"
+#include "csvexport.h"
+#include "snapshot.h"
+
+// CSV export throughput on the chain in the current directory: the
+// ofstream/operator<< loop export_to_csv() used to be, against write_csv()
+// on one thread, on every core, and with gzip. MB/s is CSV text per second
+// (before compression); the best of --rounds runs is reported. The plain
+// outputs are compared with the old one byte for byte.
+//
+// Usage: bench/bench_export.out [--rounds <n>] [--threads <n>]
+
+static const char* OLD_PATH = "bench_export_old.csv";
+static const char* NEW_PATH = "bench_export_new.csv";
+static const char* GZ_PATH = "bench_export_new.csv.gz";
+
+// The previous export_to_csv() body.
+static void export_ostream(const BlockTable& chain) {
+    std::ofstream output(OLD_PATH);
+    output << "hash,height,total,time,relayed_by,prev_block\n";
+    size_t count = chain.size();
+    for (size_t i = 0; i < count; ++i) {
+        output << chain.hash_hex(i) << ","
+               << chain.height(i) << ","
+               << chain.total(i) << ","
+               << chain.time_iso(i) << ","
+               << chain.relayed_by(i) << ","
+               << chain.prev_block_hex(i) << "\n";
+    }
+}
+
+static std::string read_file(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static double best_seconds(int rounds, const std::function<void()>& run) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = 3;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) rounds = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else {
+            std::cout << "Usage: " << argv[0] << " [--rounds <n>] [--threads <n>]\n";
+            return 1;
+        }
+    }
+
+    load_db();
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    if (chain.empty()) {
+        std::cerr << "No blocks loaded; run next to info.txt (see bench/gen_info.out).\n";
+        return 1;
+    }
+
+    double old_s = best_seconds(rounds, [&] { export_ostream(chain); });
+    std::string old_csv = read_file(OLD_PATH);
+    double mb = old_csv.size() / 1e6;
+    printf("%zu blocks, %.1f MB of CSV\n", chain.size(), mb);
+    printf("%-32s %10s %10s %8s\n", "exporter", "seconds", "MB/s", "speedup");
+    printf("%-32s %10.3f %10.1f %8.2f\n", "ofstream operator<<", old_s, mb / old_s, 1.0);
+
+    struct { std::string name; int threads; int gzip; const char* path; } runs[] = {
+        {"write_csv, 1 thread", 1, 0, NEW_PATH},
+        {"write_csv, " + std::to_string(threads) + " thread(s)", threads, 0, NEW_PATH},
+        {"write_csv gzip -1, " + std::to_string(threads) + " thread(s)", threads, 1, GZ_PATH},
+    };
+    bool same = true;
+    for (const auto& run : runs) {
+        if (&run == &runs[1] && threads == 1) continue;
+        CsvExportOptions options;
+        options.path = run.path;
+        options.threads = run.threads;
+        options.gzip_level = run.gzip;
+        CsvExportStats stats;
+        double s = best_seconds(rounds, [&] { write_csv(chain, options, &stats); });
+        printf("%-32s %10.3f %10.1f %8.2f", run.name.c_str(), s, mb / s, old_s / s);
+        if (run.gzip) printf("  (%.1f MB compressed)", stats.file_bytes / 1e6);
+        printf("\n");
+        if (!run.gzip) same = same && read_file(run.path) == old_csv;
+    }
+    printf("plain output identical to the old exporter: %s\n", same ? "yes" : "NO");
+    std::remove(OLD_PATH);
+    std::remove(NEW_PATH);
+    std::remove(GZ_PATH);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "infra.h"
+#include "csvexport.h"
+#include "csvimport.h"
+#include "snapshot.h"
+
+// CSV import throughput on the chain in the current directory: it is
+// exported with every column, then read back by a getline/split loop (the
+// obvious way to do it) and by parse_csv_file() on one thread and on every
+// core. MB/s is CSV text per second; the best of --rounds runs is reported.
+// Each imported table is compared with the exported one, column by column.
+//
+// Usage: bench/bench_import.out [--rounds <n>] [--threads <n>]
+
+static const char* CSV_PATH = "bench_import.csv";
+
+// Line by line with std::getline, fields split on ',' (no quoting).
+static void import_getline(BlockTable& out) {
+    std::ifstream input(CSV_PATH);
+    std::string line, field;
+    std::getline(input, line);  // header, known to be all columns in order
+    std::vector<std::string> f;
+    while (std::getline(input, line)) {
+        f.clear();
+        std::stringstream ss(line);
+        while (std::getline(ss, field, ',')) f.push_back(field);
+        if (f.size() != 9) continue;
+        Hash32 hash, prev;
+        int64_t time = 0;
+        from_hex(f[0], hash.bytes, 32);
+        from_hex(f[5], prev.bytes, 32);
+        parse_iso_time(f[3], &time);
+        out.append(hash, std::stoi(f[1]), std::stoll(f[2]), time, f[4], prev,
+                   std::stoi(f[6]), std::stoll(f[7]), std::stoi(f[8]));
+    }
+}
+
+template <typename T>
+static bool same_column(const T* a, const T* b, size_t n) {
+    return memcmp(a, b, n * sizeof(T)) == 0;
+}
+
+static bool same_table(const BlockTable& a, const BlockTable& b) {
+    size_t n = a.size();
+    if (b.size() != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (a.relayed_by(i) != b.relayed_by(i)) return false;
+    }
+    return same_column(a.hashes(), b.hashes(), n) && same_column(a.prev_blocks(), b.prev_blocks(), n) &&
+           same_column(a.heights(), b.heights(), n) && same_column(a.totals(), b.totals(), n) &&
+           same_column(a.times(), b.times(), n) && same_column(a.n_txs(), b.n_txs(), n) &&
+           same_column(a.fees(), b.fees(), n) && same_column(a.sizes(), b.sizes(), n);
+}
+
+static double best_seconds(int rounds, const std::function<void()>& run) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = 3;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) rounds = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else {
+            std::cout << "Usage: " << argv[0] << " [--rounds <n>] [--threads <n>]\n";
+            return 1;
+        }
+    }
+
+    load_db();
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    if (chain.empty()) {
+        std::cerr << "No blocks loaded; run next to info.txt (see bench/gen_info.out).\n";
+        return 1;
+    }
+    CsvExportOptions options;
+    options.path = CSV_PATH;
+    parse_csv_columns("all", &options.columns);
+    CsvExportStats stats;
+    if (!write_csv(chain, options, &stats)) {
+        return 1;
+    }
+    double mb = stats.text_bytes / 1e6;
+    printf("%zu blocks, %.1f MB of CSV\n", chain.size(), mb);
+    printf("%-32s %10s %10s %8s\n", "importer", "seconds", "MB/s", "speedup");
+
+    BlockTable table;
+    double old_s = best_seconds(rounds, [&] { table.clear(); import_getline(table); });
+    bool same = same_table(chain, table);
+    printf("%-32s %10.3f %10.1f %8.2f\n", "getline + split", old_s, mb / old_s, 1.0);
+
+    int counts[] = {1, threads};
+    for (int t : counts) {
+        if (&t == &counts[1] && threads == 1) continue;
+        double s = best_seconds(rounds, [&] { table.clear(); parse_csv_file(CSV_PATH, table, nullptr, t); });
+        std::string name = "parse_csv_file, " + std::to_string(t) + " thread(s)";
+        printf("%-32s %10.3f %10.1f %8.2f\n", name.c_str(), s, mb / s, old_s / s);
+        same = same && same_table(chain, table);
+    }
+    printf("imported tables identical to the exported chain: %s\n", same ? "yes" : "NO");
+    std::remove(CSV_PATH);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "infra.h"
+#include "blockview.h"
+#include "rangeindex.h"
+#include "snapshot.h"
+
+// Measures every infra.h entry point against the chain in the current
+// directory (generate one with bench/gen_info.out): throughput, latency
+// percentiles and the peak RSS while that entry point ran.
+//
+// Per-call latencies come from steady_clock around each call. Lookups use
+// keys sampled from the loaded chain (plus 10% misses). The first call to a
+// lazily indexed query builds its index, so it gets a row of its own
+// ("... first") instead of ending up in the p99s.
+// print_db()/find_block_*() write to /dev/null; export_to_csv() writes
+// infoutput.csv in the current directory.
+//
+// Peak RSS is reset before each row through /proc/self/clear_refs, so each
+// row shows what that entry point needed on top of the loaded chain.
+//
+// Usage: bench/bench_infra.out [--lookups <n>] [--rounds <n>] [--no-print]
+
+struct Row {
+    std::string name;
+    std::vector<double> latencies_us;
+    double seconds = 0;
+    long peak_rss_kb = 0;
+};
+
+static void reset_peak_rss() {
+    int fd = open("/proc/self/clear_refs", O_WRONLY);
+    if (fd >= 0) {
+        ssize_t n = write(fd, "5", 1);
+        (void)n;
+        close(fd);
+    }
+}
+
+static long peak_rss_kb() {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    long kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmHWM:", 6) == 0) kb = atol(line + 6);
+    }
+    fclose(f);
+    return kb;
+}
+
+// Points stdout at /dev/null while the print functions run.
+class Silence {
+public:
+    Silence() {
+        std::cout.flush();
+        fflush(stdout);
+        saved_ = dup(1);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, 1);
+        close(null_fd);
+    }
+    ~Silence() {
+        std::cout.flush();
+        fflush(stdout);
+        dup2(saved_, 1);
+        close(saved_);
+    }
+
+private:
+    int saved_;
+};
+
+static Row measure(const std::string& name, size_t ops, const std::function<void(size_t)>& op) {
+    Row row;
+    row.name = name;
+    row.latencies_us.reserve(ops);
+    reset_peak_rss();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        op(i);
+        auto t1 = std::chrono::steady_clock::now();
+        row.latencies_us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+    row.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    row.peak_rss_kb = peak_rss_kb();
+    return row;
+}
+
+static void report(Row& row) {
+    std::vector<double>& lat = row.latencies_us;
+    if (lat.empty()) return;
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) { return lat[std::min(lat.size() - 1, (size_t)(p * lat.size()))]; };
+    printf("%-26s %9zu %12.0f %11.1f %11.1f %11.1f %11.1f %9.1f\n", row.name.c_str(), lat.size(),
+           lat.size() / (row.seconds > 0 ? row.seconds : 1e-9), pct(0.50), pct(0.90), pct(0.99), lat.back(),
+           row.peak_rss_kb / 1024.0);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    size_t lookups = 100000;
+    size_t rounds = 3;
+    bool with_print = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lookups" && i + 1 < argc) lookups = std::max(1L, atol(argv[++i]));
+        else if (arg == "--rounds" && i + 1 < argc) rounds = std::max(1L, atol(argv[++i]));
+        else if (arg == "--no-print") with_print = false;
+        else {
+            std::cout << "Usage: " << argv[0] << " [--lookups <n>] [--rounds <n>] [--no-print]\n";
+            return 1;
+        }
+    }
+
+    printf("%-26s %9s %12s %11s %11s %11s %11s %9s\n", "entry point", "calls", "calls/s", "p50 us", "p90 us",
+           "p99 us", "max us", "peak MB");
+    Row load = measure("load_db", rounds, [](size_t) { load_db(); });
+    report(load);
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    size_t n = chain.size();
+    if (n == 0) {
+        std::cerr << "No blocks loaded; run next to info.txt (see bench/gen_info.out).\n";
+        return 1;
+    }
+
+    // Keys: 90% from the chain, 10% that miss.
+    std::mt19937_64 rng(42);
+    std::vector<std::string> hashes(lookups), prefixes(lookups);
+    std::vector<int> heights(lookups);
+    std::vector<int64_t> times(lookups);
+    for (size_t i = 0; i < lookups; ++i) {
+        size_t row = rng() % n;
+        bool miss = rng() % 10 == 0;
+        hashes[i] = chain.hash_hex(row);
+        if (miss) hashes[i][63] = hashes[i][63] == '0' ? '1' : '0';
+        prefixes[i] = hashes[i].substr(0, 28);
+        heights[i] = chain.height(row) + (miss ? (int)n + 1 : 0);
+        times[i] = chain.time(row);
+    }
+
+    std::vector<Row> rows;
+    size_t found;
+    rows.push_back(measure("lookup_hash", lookups, [&](size_t i) { lookup_hash(hashes[i], &found); }));
+    rows.push_back(measure("lookup_height", lookups, [&](size_t i) { lookup_height(heights[i], &found); }));
+    {
+        BlockQuery query;
+        BlockRef block;
+        rows.push_back(measure("BlockQuery::find_hash", lookups, [&](size_t i) { query.find_hash(hashes[i], &block); }));
+        rows.push_back(measure("BlockQuery::find_height", lookups, [&](size_t i) {
+            query.find_height(heights[i], &block);
+        }));
+        InfraSnapshot* snapshot = infra_acquire();
+        InfraBlock c_block;
+        rows.push_back(measure("infra_find_height (C)", lookups, [&](size_t i) {
+            infra_find_height(snapshot, heights[i], &c_block);
+        }));
+        infra_release(snapshot);
+    }
+    {
+        Silence quiet;
+        rows.push_back(measure("find_block_by_hash", lookups, [&](size_t i) {
+            find_block_by_hash(hashes[i].c_str());
+        }));
+        rows.push_back(measure("find_block_by_height", lookups, [&](size_t i) {
+            find_block_by_height(heights[i]);
+        }));
+    }
+
+    std::vector<size_t> matches;
+    size_t count;
+    rows.push_back(measure("lookup_hash_prefix first", 1, [&](size_t) {
+        lookup_hash_prefix(prefixes[0], 10, &matches, &count);
+    }));
+    rows.push_back(measure("lookup_hash_prefix", lookups, [&](size_t i) {
+        lookup_hash_prefix(prefixes[i], 10, &matches, &count);
+    }));
+
+    RangeStats stats;
+    rows.push_back(measure("query_range first", 1, [&](size_t) {
+        query_range(heights[0], heights[0] + 1000, &stats);
+    }));
+    rows.push_back(measure("query_range (1000)", lookups, [&](size_t i) {
+        query_range(heights[i], heights[i] + 1000, &stats);
+    }));
+    rows.push_back(measure("query_top_k (10 of 1000)", lookups, [&](size_t i) {
+        query_top_k(heights[i], heights[i] + 1000, 10);
+    }));
+    rows.push_back(measure("query_time_range first", 1, [&](size_t) {
+        query_time_range(times[0], times[0] + 3600);
+    }));
+    rows.push_back(measure("query_time_range (1 h)", lookups, [&](size_t i) {
+        query_time_range(times[i], times[i] + 3600);
+    }));
+    size_t ancestor;
+    rows.push_back(measure("query_ancestor first", 1, [&](size_t) { query_ancestor(0, 1, &ancestor); }));
+    rows.push_back(measure("query_ancestor", lookups, [&](size_t i) {
+        query_ancestor(i % n, (uint32_t)(rng() % 1000), &ancestor);
+    }));
+
+    if (with_print) {
+        Silence quiet;
+        rows.push_back(measure("print_db", rounds, [](size_t) { print_db(); }));
+        rows.push_back(measure("export_to_csv", rounds, [](size_t) { export_to_csv(); }));
+    }
+    for (auto& row : rows) {
+        report(row);
+    }
+    // Latencies are sorted by now: [0] is the best round.
+    printf("%zu blocks; best blocks/s for load_db: %.0f", n, n / (load.latencies_us[0] / 1e6));
+    if (with_print) {
+        printf(", print_db: %.0f, export_to_csv: %.0f", n / (rows[rows.size() - 2].latencies_us[0] / 1e6),
+               n / (rows.back().latencies_us[0] / 1e6));
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sys/stat.h>
+#include "json.h"
+#include "refresh.h"
+
+// Compares reading NDJSON block documents one line at a time with
+// block_from_json(), as the refresh reads single API responses (the same
+// json.cpp parser, one call and one Block per document), and the whole
+// file in one structural scan, in MB/s.
+//
+// Usage: bench/bench_json.out <blocks.ndjson> [rounds] [fields]
+
+static size_t member_load(const std::string& path, BlockTable& out) {
+    std::ifstream file(path);
+    std::string line;
+    out.clear();
+    while (std::getline(file, line)) {
+        Block b;
+        if (block_from_json(line, &b)) out.append(b);
+    }
+    return out.size();
+}
+
+static size_t scan_load(const std::string& path, uint32_t fields, BlockTable& out) {
+    out.clear();
+    ParseReport report;
+    parse_json_file(path, fields, out, &report);
+    return report.blocks;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <blocks.ndjson> [rounds] [fields]\n";
+        return 1;
+    }
+    std::string path = argv[1];
+    int rounds = argc > 2 ? std::stoi(argv[2]) : 3;
+    uint32_t fields = FIELDS_ALL;
+    if (argc > 3 && !parse_field_list(argv[3], &fields)) {
+        std::cerr << "Unknown field in '" << argv[3] << "'\n";
+        return 1;
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        std::cerr << "Failed to open " << path << "\n";
+        return 1;
+    }
+    double mb = st.st_size / (1024.0 * 1024.0);
+
+    BlockTable table;
+    double best_member = 1e100, best_scan = 1e100;
+    size_t n_member = 0, n_scan = 0;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        n_member = member_load(path, table);
+        auto t1 = std::chrono::steady_clock::now();
+        n_scan = scan_load(path, fields, table);
+        auto t2 = std::chrono::steady_clock::now();
+        best_member = std::min(best_member, std::chrono::duration<double>(t1 - t0).count());
+        best_scan = std::min(best_scan, std::chrono::duration<double>(t2 - t1).count());
+    }
+
+    std::cout << path << ": " << mb << " MB, best of " << rounds << " rounds\n";
+    std::cout << "  block_from_json/line : " << n_member << " blocks, " << best_member * 1e3 << " ms, "
+              << mb / best_member << " MB/s\n";
+    std::cout << "  structural scan      : " << n_scan << " blocks, " << best_scan * 1e3 << " ms, "
+              << mb / best_scan << " MB/s\n";
+    std::cout << "  speedup              : " << best_member / best_scan << "x\n";
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sys/stat.h>
+#include "infra.h"
+#include "parser.h"
+
+// Compares the old getline + cleanLine + stoi loader with the zero-copy
+// parser used by load_db() today, in blocks per second.
+//
+// Usage: bench/bench_parse.out [info.txt] [rounds]
+
+// The loader as it was before parser.cpp, kept here as the baseline.
+static size_t legacy_load(const std::string& path, std::vector<Block>& out) {
+    std::ifstream file(path);
+    std::string line;
+    std::vector<std::string> blockLines;
+    out.clear();
+
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        blockLines.push_back(line);
+
+        if (blockLines.size() == 6) {
+            Block b;
+            try {
+                b.hash = cleanLine(blockLines[0]);
+                b.height = std::stoi(cleanLine(blockLines[1]));
+                b.total = std::stoll(cleanLine(blockLines[2]));
+                b.time = cleanLine(blockLines[3]);
+                b.relayed_by = cleanLine(blockLines[4]);
+                b.prev_block = cleanLine(blockLines[5]);
+            } catch (...) {
+                blockLines.clear();
+                continue;
+            }
+            out.push_back(b);
+            blockLines.clear();
+        }
+    }
+    return out.size();
+}
+
+static size_t new_load(const std::string& path, BlockTable& out) {
+    out.clear();
+    ParseReport report;
+    parse_info_file(path, out, &report);
+    return report.blocks;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "info.txt";
+    int rounds = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        std::cerr << "Failed to open " << path << "\n";
+        return 1;
+    }
+    double mb = st.st_size / (1024.0 * 1024.0);
+
+    std::vector<Block> legacy;
+    BlockTable table;
+    double best_legacy = 1e100, best_new = 1e100;
+    size_t n_legacy = 0, n_new = 0;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        n_legacy = legacy_load(path, legacy);
+        auto t1 = std::chrono::steady_clock::now();
+        n_new = new_load(path, table);
+        auto t2 = std::chrono::steady_clock::now();
+        best_legacy = std::min(best_legacy, std::chrono::duration<double>(t1 - t0).count());
+        best_new = std::min(best_new, std::chrono::duration<double>(t2 - t1).count());
+    }
+
+    std::cout << path << ": " << mb << " MB, best of " << rounds << " rounds\n";
+    std::cout << "  legacy getline/stoi : " << n_legacy << " blocks, " << best_legacy * 1e3 << " ms, "
+              << (size_t)(n_legacy / best_legacy) << " blocks/s, " << mb / best_legacy << " MB/s\n";
+    std::cout << "  zero-copy parser    : " << n_new << " blocks, " << best_new * 1e3 << " ms, "
+              << (size_t)(n_new / best_new) << " blocks/s, " << mb / best_new << " MB/s\n";
+    std::cout << "  speedup             : " << best_legacy / best_new << "x\n";
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "segstore.h"
+
+// Height and hash lookups against info.seg (see txt2db.out --segments) in
+// the current directory, for several segment cache limits: lookups/s, cache
+// hit rate, segments decoded and what the cache held at the end. Key mixes:
+//   uniform - heights drawn evenly from the whole chain,
+//   recent  - 90% from the newest 10% of heights (what explorers mostly see).
+//
+// Usage: bench/bench_segments.out [--lookups <n>] [--cache-mb <n>[,<n>...]]
+
+int main(int argc, char* argv[]) {
+    size_t lookups = 20000;
+    std::vector<size_t> limits_mb = {1, 8, 64};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lookups" && i + 1 < argc) {
+            lookups = std::max(1L, atol(argv[++i]));
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            limits_mb.clear();
+            for (char* p = argv[++i]; *p;) {
+                limits_mb.push_back(strtoul(p, &p, 10));
+                if (*p == ',') ++p;
+                else if (*p) break;
+            }
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--lookups <n>] [--cache-mb <n>[,<n>...]]\n";
+            return 1;
+        }
+    }
+
+    SegmentStore store;
+    if (!store.open(SEGSTORE_FILE, 0) || store.size() == 0) {
+        std::cerr << "No " << SEGSTORE_FILE << " here; run txt2db.out --segments 2016 first.\n";
+        return 1;
+    }
+    int lo = store.segment_info(0).min_height;
+    int hi = store.segment_info(store.segment_count() - 1).max_height;
+
+    // Hash keys need the blocks themselves: take them from the segments
+    // before measuring (with no cache to speak of yet).
+    std::mt19937_64 rng(42);
+    std::vector<int> uniform(lookups), recent(lookups);
+    int span = hi - lo + 1;
+    for (size_t i = 0; i < lookups; ++i) {
+        uniform[i] = lo + (int)(rng() % span);
+        recent[i] = rng() % 10 == 0 ? lo + (int)(rng() % span) : hi - (int)(rng() % std::max(1, span / 10));
+    }
+    std::vector<Hash32> hashes;
+    hashes.reserve(lookups);
+    for (size_t i = 0; i < lookups; ++i) {
+        SegmentPtr seg;
+        size_t row;
+        if (store.find_height(uniform[i], &seg, &row)) hashes.push_back(seg->hash(row));
+    }
+
+    printf("%zu blocks in %zu segments of %u heights\n", store.size(), store.segment_count(),
+           store.segment_blocks());
+
+    // The hash directory must single out the tip's segment: one segment
+    // touched, not every segment whose hashes share leading zeros.
+    {
+        SegmentPtr seg;
+        size_t row;
+        if (!store.find_height(hi, &seg, &row)) return 1;
+        Hash32 tip = seg->hash(row);
+        seg.reset();
+        store.set_cache_limit(0);
+        SegmentCacheStats before = store.cache_stats();
+        bool ok = store.find_hash(tip, &seg, &row) && seg->heights()[row] == hi;
+        SegmentCacheStats after = store.cache_stats();
+        uint64_t touched = after.hits - before.hits + after.misses - before.misses;
+        printf("tip hash lookup: %llu segment(s)\n", (unsigned long long)touched);
+        if (!ok || touched != 1) {
+            std::cerr << "Tip hash lookup touched " << touched << " segments, expected 1\n";
+            return 1;
+        }
+    }
+    printf("%-16s %9s %12s %9s %9s %10s\n", "lookup", "cache MB", "lookups/s", "hit %", "decoded", "cached MB");
+    for (size_t mb : limits_mb) {
+        struct { const char* name; const std::vector<int>* heights; } mixes[] = {
+            {"height uniform", &uniform}, {"height recent", &recent}, {"hash uniform", nullptr}};
+        for (const auto& mix : mixes) {
+            store.set_cache_limit(0);  // keeps only the newest segment
+            store.set_cache_limit(mb << 20);
+            SegmentCacheStats before = store.cache_stats();
+            size_t found = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            SegmentPtr seg;
+            size_t row;
+            if (mix.heights) {
+                for (int h : *mix.heights) found += store.find_height(h, &seg, &row);
+            } else {
+                for (const Hash32& h : hashes) found += store.find_hash(h, &seg, &row);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            seg.reset();
+            SegmentCacheStats after = store.cache_stats();
+            uint64_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+            size_t ops = mix.heights ? mix.heights->size() : hashes.size();
+            printf("%-16s %9zu %12.0f %9.1f %9llu %10.1f\n", mix.name, mb, ops / (seconds > 0 ? seconds : 1e-9),
+                   100.0 * hits / std::max<uint64_t>(1, hits + misses), (unsigned long long)misses,
+                   after.bytes / 1048576.0);
+            if (found == 0) return 1;
+        }
+    }
+    return 0;
+}
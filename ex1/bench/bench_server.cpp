@@ -0,0 +1,114 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "infra.h"
+#include "client.h"
+#include "server.h"
+#include "snapshot.h"
+
+// Load generator for blockd.out: N client threads, each on its own
+// connection, send a random mix of hash/height/range requests in a closed
+// loop for a fixed time and record per-request latency. Keys are sampled
+// from the chain in the current directory (load_db()), so run it next to
+// the same info.db / info.txt as the server.
+//
+// Usage: bench/bench_server.out [--socket <path>] [--clients <n>] [--seconds <s>] [--ranges <percent>]
+
+struct ClientResult {
+    std::vector<uint32_t> latencies_us;
+    size_t errors = 0;
+};
+
+static void run_client(const BlockTable* chain, const std::string& socket_path, double seconds, int range_percent,
+                       unsigned seed, ClientResult* result) {
+    BlockClient client;
+    if (!client.connect(socket_path)) {
+        std::cerr << client.error() << std::endl;
+        ++result->errors;
+        return;
+    }
+
+    std::mt19937 rng(seed);
+    size_t n = chain->size();
+    std::string request, response;
+    auto stop = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    for (;;) {
+        size_t row = rng() % n;
+        int kind = (int)(rng() % 100);
+        if (kind < range_percent) {
+            int from = chain->height(row);
+            request = "r " + std::to_string(from) + " " + std::to_string(from + (int)(rng() % 1000));
+        } else if (kind % 2 == 0) {
+            request = "h " + chain->hash_hex(row);
+        } else {
+            request = "n " + std::to_string(chain->height(row));
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        if (t0 >= stop) break;
+        if (!client.query(request, &response)) {
+            ++result->errors;
+            break;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        if (response.compare(0, 2, "ok") != 0) ++result->errors;
+        result->latencies_us.push_back(
+            (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = DEFAULT_SERVER_SOCKET;
+    int clients = 8;
+    double seconds = 5;
+    int range_percent = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--socket") socket_path = argv[i + 1];
+        else if (arg == "--clients") clients = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--seconds") seconds = atof(argv[i + 1]);
+        else if (arg == "--ranges") range_percent = atoi(argv[i + 1]);
+    }
+
+    load_db();
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    if (snap->table().empty()) {
+        std::cerr << "No blocks loaded; run next to info.db / info.txt.\n";
+        return 1;
+    }
+
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back(run_client, &snap->table(), socket_path, seconds, range_percent, 1234u + c, &results[c]);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::vector<uint32_t> all;
+    size_t errors = 0;
+    for (const auto& r : results) {
+        all.insert(all.end(), r.latencies_us.begin(), r.latencies_us.end());
+        errors += r.errors;
+    }
+    if (all.empty()) {
+        std::cerr << "No requests completed.\n";
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&all](double p) { return all[std::min(all.size() - 1, (size_t)(p * all.size()))]; };
+
+    std::cout << clients << " clients, " << elapsed << " s, " << all.size() << " requests, " << errors
+              << " errors\n";
+    std::cout << "  throughput : " << (size_t)(all.size() / elapsed) << " queries/s\n";
+    std::cout << "  latency us : p50 " << pct(0.50) << ", p90 " << pct(0.90) << ", p99 " << pct(0.99)
+              << ", max " << all.back() << "\n";
+    return 0;
+}
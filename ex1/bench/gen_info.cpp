@@ -0,0 +1,108 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include "infra.h"
+
+// Writes a synthetic info.txt in the layout blockchain1.sh produces (tip
+// first, six lines per block), so load/lookup/print/export can be measured
+// at sizes the API would take days to deliver.
+//
+// Every field is a pure function of (seed, height), so blocks can be written
+// newest first without keeping the chain in memory, and the same arguments
+// always give the same file:
+//   - hashes start with 19 zero hex digits like real proof-of-work hashes,
+//     and prev_block is the hash of the block one height lower,
+//   - times advance 600 s per block with up to +-20 min of jitter, so they
+//     are not monotonic (as on the real chain),
+//   - totals are log-uniform between 0.01 and 10,000 BTC,
+//   - relayed_by comes from a small skewed set of peers, mostly empty.
+//
+// Usage: bench/gen_info.out <blocks> [<output>] [--seed <n>] [--start <height>]
+
+static const int64_t BASE_TIME = 1704067200;  // 2024-01-01T00:00:00Z
+static const char* const PEERS[] = {"", "", "", "", "", "", "", "", "", "",
+                                    "18.1.2.3:8333", "34.1.2.3:8333", "52.1.2.3:8333", "95.1.2.3:8333",
+                                    "138.1.2.3:8333", "172.1.2.3:8333"};
+
+static uint64_t mix(uint64_t x) {
+    // splitmix64 finaliser
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t draw(uint64_t seed, int64_t height, uint64_t field) {
+    return mix(seed ^ mix((uint64_t)height * 8 + field));
+}
+
+static void block_hash(uint64_t seed, int64_t height, char* out) {
+    uint8_t bytes[32];
+    for (int w = 0; w < 4; ++w) {
+        uint64_t v = draw(seed, height, 4 + w);
+        memcpy(bytes + 8 * w, &v, 8);
+    }
+    memset(bytes, 0, 9);
+    bytes[9] &= 0x0F;  // 19 leading zero digits
+    std::string hex = to_hex(bytes, 32);
+    memcpy(out, hex.data(), 64);
+    out[64] = '\0';
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <blocks> [<output>] [--seed <n>] [--start <height>]\n";
+        return 1;
+    }
+    long long blocks = atoll(argv[1]);
+    std::string path = "info.txt";
+    uint64_t seed = 1;
+    int64_t start = 700000;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--start" && i + 1 < argc) start = atoll(argv[++i]);
+        else path = arg;
+    }
+    if (blocks <= 0 || start < 0 || start + blocks > INT32_MAX) {
+        std::cerr << "Invalid block count or start height.\n";
+        return 1;
+    }
+
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Failed to create " << path << "\n";
+        return 1;
+    }
+    static char buffer[1 << 20];
+    setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+
+    char hash[65], prev[65];
+    block_hash(seed, start + blocks - 1, hash);
+    for (int64_t height = start + blocks - 1; height >= start; --height) {
+        block_hash(seed, height - 1, prev);
+        int64_t jitter = (int64_t)(draw(seed, height, 0) % 2401) - 1200;
+        int64_t time = BASE_TIME + (height - start) * 600 + jitter;
+        // 10^6 .. 10^12 satoshis, uniform in the exponent.
+        double exponent = 6.0 + 6.0 * (double)(draw(seed, height, 1) >> 11) / (double)(1ULL << 53);
+        int64_t total = (int64_t)std::pow(10.0, exponent);
+        const char* peer = PEERS[draw(seed, height, 2) % (sizeof(PEERS) / sizeof(PEERS[0]))];
+
+        fprintf(out,
+                "  \"hash\": \"%s\",\n  \"height\": %lld,\n  \"total\": %lld,\n  \"time\": \"%s\",\n"
+                "  \"relayed_by\": \"%s\",\n  \"prev_block\": \"%s\",\n\n\n\n\n",
+                hash, (long long)height, (long long)total, format_iso_time(time).c_str(), peer, prev);
+        memcpy(hash, prev, sizeof(hash));
+    }
+    if (fclose(out) != 0) {
+        std::cerr << "Failed to write " << path << "\n";
+        return 1;
+    }
+    std::cerr << "Wrote " << blocks << " blocks (heights " << start << " - " << start + blocks - 1 << ") to "
+              << path << "\n";
+    return 0;
+}
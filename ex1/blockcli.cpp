@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "client.h"
+#include "server.h"
+
+// Client for blockd.out.
+//   ./blockcli.out [--socket <path>] h <hash> | n <height> | r <from> <to> | t <k> [<from> <to>]
+// Without a request, reads request lines from stdin, sends them all
+// (pipelined) and prints the raw response lines in order.
+
+static std::vector<std::string> split_tabs(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, '\t')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// Prints a response the way the other ex1 programs print results.
+static void print_response(const std::string& command, const std::string& response) {
+    std::vector<std::string> f = split_tabs(response);
+    if (f.empty() || f[0] != "ok") {
+        std::cout << (response == "nf" ? "Not found." : response) << "\n";
+        return;
+    }
+    if ((command == "h" || command == "n") && f.size() >= 7) {
+        const char* names[] = {"hash", "height", "total", "time", "relayed_by", "prev_block", "n_tx", "fees", "size"};
+        for (size_t i = 1; i < f.size() && i <= 9; ++i) {
+            std::cout << names[i - 1] << ": " << f[i] << "\n";
+        }
+    } else if (command == "r" && f.size() == 6) {
+        std::cout << "blocks: " << f[1] << "\nsum: " << f[2] << "\nmin: " << f[3] << "\nmax: " << f[4]
+                  << "\navg: " << f[5] << "\n";
+    } else if (command == "t") {
+        for (size_t i = 2; i < f.size(); ++i) {
+            std::cout << i - 1 << ". " << f[i] << "\n";
+        }
+    } else {
+        std::cout << response << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = DEFAULT_SERVER_SOCKET;
+    int first = 1;
+    if (argc > 2 && std::string(argv[1]) == "--socket") {
+        socket_path = argv[2];
+        first = 3;
+    }
+
+    BlockClient client;
+    if (!client.connect(socket_path)) {
+        std::cerr << client.error() << std::endl;
+        return 1;
+    }
+
+    std::string response;
+    if (first < argc) {
+        std::string request = argv[first];
+        for (int i = first + 1; i < argc; ++i) {
+            request += ' ';
+            request += argv[i];
+        }
+        if (!client.query(request, &response)) {
+            std::cerr << client.error() << std::endl;
+            return 1;
+        }
+        print_response(argv[first], response);
+        return response.compare(0, 2, "ok") == 0 ? 0 : 2;
+    }
+
+    // Batch: pipeline requests in windows, so neither side can fill its
+    // socket buffer while the other is still writing.
+    const size_t WINDOW = 256;
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty()) requests.push_back(line);
+    }
+    std::string out;
+    for (size_t start = 0; start < requests.size(); start += WINDOW) {
+        size_t end = std::min(requests.size(), start + WINDOW);
+        std::string batch = requests[start];
+        for (size_t i = start + 1; i < end; ++i) {
+            batch += '\n';
+            batch += requests[i];
+        }
+        if (!client.send(batch)) {
+            std::cerr << client.error() << std::endl;
+            return 1;
+        }
+        for (size_t i = start; i < end; ++i) {
+            if (!client.receive(&response)) {
+                std::cerr << client.error() << std::endl;
+                return 1;
+            }
+            out += response;
+            out += '\n';
+        }
+    }
+    std::cout << out;
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <csignal>
+#include "infra.h"
+#include "snapshot.h"
+#include "server.h"
+
+// Query daemon: loads the chain once and answers requests over a Unix
+// socket until SIGINT/SIGTERM (protocol in server.h, client: blockcli.out).
+static void on_signal(int) {
+    request_server_stop();
+}
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = DEFAULT_SERVER_SOCKET;
+    int threads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--socket <path>] [--threads <n>]\n";
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    load_db();
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Serving " << chain_snapshot()->size() << " blocks on " << socket_path << " with " << threads
+              << " thread(s)." << std::endl;
+    if (!run_server(socket_path, threads)) {
+        return 1;
+    }
+    std::cout << "Server stopped." << std::endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "blockindex.h"
+#include <algorithm>
+#include <cstring>
+
+HashIndex::HashIndex() : keys_(nullptr), mask_(0), size_(0), indexed_(0) {}
+
+void HashIndex::clear() {
+    std::vector<uint32_t>().swap(table_);
+    keys_ = nullptr;
+    mask_ = 0;
+    size_ = 0;
+    indexed_ = 0;
+}
+
+void HashIndex::build(const Hash32* keys, size_t count) {
+    clear();
+    extend(keys, count);
+}
+
+void HashIndex::extend(const Hash32* keys, size_t count) {
+    keys_ = keys;
+    if (table_.size() < count * 2 || table_.empty()) {
+        size_t capacity = 16;
+        while (capacity < count * 2) capacity <<= 1;
+        rehash(capacity);
+    }
+    for (; indexed_ < count; ++indexed_) {
+        insert((uint32_t)indexed_);
+    }
+}
+
+// Re-inserts the slots indexed so far into a table of `capacity` entries.
+void HashIndex::rehash(size_t capacity) {
+    table_.assign(capacity, NO_SLOT);
+    mask_ = capacity - 1;
+    size_ = 0;
+    for (size_t i = 0; i < indexed_; ++i) {
+        insert((uint32_t)i);
+    }
+}
+
+// Block hashes are SHA-256 output, so any 8 bytes are already well mixed.
+// The leading bytes are mostly zero (proof of work), so use the trailing ones.
+size_t HashIndex::probe_start(const Hash32& key) const {
+    uint64_t h;
+    memcpy(&h, key.bytes + 24, sizeof(h));
+    return (size_t)(h ^ (h >> 29)) & mask_;
+}
+
+bool HashIndex::insert(uint32_t slot) {
+    const Hash32& key = keys_[slot];
+    for (size_t i = probe_start(key);; i = (i + 1) & mask_) {
+        uint32_t cur = table_[i];
+        if (cur == NO_SLOT) {
+            table_[i] = slot;
+            ++size_;
+            return true;
+        }
+        if (memcmp(keys_[cur].bytes, key.bytes, 32) == 0) {
+            return false;  // Keep the first occurrence, like the old linear scan
+        }
+    }
+}
+
+uint32_t HashIndex::find(const Hash32& key) const {
+    if (table_.empty()) return NO_SLOT;
+    for (size_t i = probe_start(key);; i = (i + 1) & mask_) {
+        uint32_t cur = table_[i];
+        if (cur == NO_SLOT || memcmp(keys_[cur].bytes, key.bytes, 32) == 0) {
+            return cur;
+        }
+    }
+}
+
+HeightIndex::HeightIndex() : base_(0) {}
+
+void HeightIndex::clear() {
+    std::vector<uint32_t>().swap(slots_);
+    base_ = 0;
+}
+
+bool HeightIndex::build(const int32_t* heights, size_t count) {
+    clear();
+    if (count == 0) return true;
+
+    auto range = std::minmax_element(heights, heights + count);
+    int64_t span = (int64_t)*range.second - *range.first + 1;
+    // Refuse to allocate for wildly sparse (likely corrupt) heights.
+    if (span > (int64_t)count * 4 + 1024) {
+        return false;
+    }
+
+    base_ = *range.first;
+    slots_.assign((size_t)span, NO_SLOT);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t& s = slots_[(size_t)(heights[i] - base_)];
+        if (s == NO_SLOT) s = (uint32_t)i;  // First occurrence wins
+    }
+    return true;
+}
+
+bool HeightIndex::extend(const int32_t* heights, size_t from, size_t count) {
+    if (slots_.empty()) return build(heights, count);
+    for (size_t i = from; i < count; ++i) {
+        // Check the span the height would need before growing anything, so a
+        // stray height can't allocate gigabytes first.
+        int64_t lo = std::min<int64_t>(base_, heights[i]);
+        int64_t hi = std::max<int64_t>(base_ + (int64_t)slots_.size() - 1, heights[i]);
+        if (hi - lo + 1 > (int64_t)count * 4 + 1024) {
+            clear();
+            return false;
+        }
+        int64_t off = (int64_t)heights[i] - base_;
+        if (off < 0) {
+            // Lower than anything seen so far: shift the array up.
+            slots_.insert(slots_.begin(), (size_t)-off, NO_SLOT);
+            base_ = heights[i];
+            off = 0;
+        } else if (off >= (int64_t)slots_.size()) {
+            slots_.resize((size_t)off + 1, NO_SLOT);
+        }
+        if (slots_[(size_t)off] == NO_SLOT) slots_[(size_t)off] = (uint32_t)i;
+    }
+    return true;
+}
+
+uint32_t HeightIndex::find(int height) const {
+    int64_t off = (int64_t)height - base_;
+    if (off < 0 || off >= (int64_t)slots_.size()) return NO_SLOT;
+    return slots_[(size_t)off];
+}
+
+HashPrefixIndex::HashPrefixIndex() : keys_(nullptr) {}
+
+void HashPrefixIndex::clear() {
+    std::vector<uint32_t>().swap(order_);
+    keys_ = nullptr;
+}
+
+void HashPrefixIndex::build(const Hash32* keys, size_t count) {
+    keys_ = keys;
+    order_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order_[i] = (uint32_t)i;
+    }
+    // Hex digits are in byte order, so comparing the raw bytes sorts the
+    // same way as comparing the hex strings.
+    std::sort(order_.begin(), order_.end(),
+              [keys](uint32_t a, uint32_t b) { return memcmp(keys[a].bytes, keys[b].bytes, 32) < 0; });
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool HashPrefixIndex::find(std::string_view prefix, size_t* first, size_t* last) const {
+    *first = *last = 0;
+    if (prefix.empty() || prefix.size() > 64) return false;
+
+    // The matches are exactly the hashes between the prefix padded with 0s
+    // and the prefix padded with fs.
+    Hash32 low, high;
+    memset(low.bytes, 0x00, sizeof(low.bytes));
+    memset(high.bytes, 0xFF, sizeof(high.bytes));
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        int d = hex_digit(prefix[i]);
+        if (d < 0) return false;
+        uint8_t shift = (i % 2 == 0) ? 4 : 0;
+        low.bytes[i / 2] = (uint8_t)((low.bytes[i / 2] & ~(0x0F << shift)) | (d << shift));
+        high.bytes[i / 2] = (uint8_t)((high.bytes[i / 2] & ~(0x0F << shift)) | (d << shift));
+    }
+
+    const Hash32* keys = keys_;
+    auto below = [keys](uint32_t row, const Hash32& key) { return memcmp(keys[row].bytes, key.bytes, 32) < 0; };
+    auto above = [keys](const Hash32& key, uint32_t row) { return memcmp(key.bytes, keys[row].bytes, 32) < 0; };
+    *first = std::lower_bound(order_.begin(), order_.end(), low, below) - order_.begin();
+    *last = std::upper_bound(order_.begin() + *first, order_.end(), high, above) - order_.begin();
+    return true;
+}
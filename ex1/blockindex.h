@@ -0,0 +1,82 @@
+#ifndef BLOCKINDEX_H
+#define BLOCKINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "chain.h"
+
+#define NO_SLOT UINT32_MAX
+
+// Open-addressing (linear probing) hash table from a 32-byte binary block hash
+// to its slot in the loaded chain. The table only holds 4-byte slot ids (kept
+// at most half full); keys are compared against the chain's hash column,
+// which must outlive the index.
+class HashIndex {
+public:
+    HashIndex();
+
+    void clear();
+    void build(const Hash32* keys, size_t count);
+    // Indexes slots [indexed, count) after blocks were appended to the chain.
+    // `keys` is passed again because appending may have moved the column.
+    void extend(const Hash32* keys, size_t count);
+    uint32_t find(const Hash32& key) const;  // NO_SLOT if missing
+    size_t size() const { return size_; }
+
+private:
+    size_t probe_start(const Hash32& key) const;
+    bool insert(uint32_t slot);  // false if the key already exists
+    void rehash(size_t capacity);
+
+    std::vector<uint32_t> table_;
+    const Hash32* keys_;
+    size_t mask_;
+    size_t size_;
+    size_t indexed_;  // slots [0, indexed_) have been inserted
+};
+
+// Direct height -> slot array. Block heights are dense, so a flat vector
+// offset by the lowest height gives O(1) lookups.
+class HeightIndex {
+public:
+    HeightIndex();
+
+    void clear();
+    // Returns false (and stays empty) if the heights are too sparse to index.
+    bool build(const int32_t* heights, size_t count);
+    // Adds slots [from, count); returns false if the heights became too sparse.
+    bool extend(const int32_t* heights, size_t from, size_t count);
+    uint32_t find(int height) const;
+
+private:
+    std::vector<uint32_t> slots_;
+    int64_t base_;
+};
+
+// Block hashes in sorted (hex string) order, for "every block whose hash
+// starts with these digits". All hashes sharing a prefix form one run of the
+// sorted order, so a lookup is two binary searches and the k matches are
+// read off in O(log n + k). Only 4-byte rows are stored; comparisons go to
+// the chain's hash column, which must outlive the index.
+class HashPrefixIndex {
+public:
+    HashPrefixIndex();
+
+    void clear();
+    void build(const Hash32* keys, size_t count);
+    size_t size() const { return order_.size(); }
+
+    // Positions [*first, *last) of the hashes starting with `prefix`, 1 to 64
+    // hex digits in either case (an odd count is fine). Returns false if
+    // `prefix` is empty, too long or not hex.
+    bool find(std::string_view prefix, size_t* first, size_t* last) const;
+    uint32_t row(size_t pos) const { return order_[pos]; }
+
+private:
+    std::vector<uint32_t> order_;  // rows sorted by hash
+    const Hash32* keys_;
+};
+
+#endif // BLOCKINDEX_H
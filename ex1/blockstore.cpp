@@ -0,0 +1,285 @@
+#include "blockstore.h"
+#include "infra.h"
+#include "json.h"
+#include "csvimport.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+BlockStore::BlockStore()
+    : map_(nullptr), map_len_(0), header_(nullptr), columns_(nullptr), count_(0) {}
+
+BlockStore::~BlockStore() {
+    close();
+}
+
+// Maps the whole file read-only and validates the header and the column
+// directory against the file size. Column data is served from the mapping.
+bool BlockStore::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(StoreHeader)) {
+        ::close(fd);
+        std::cerr << path << ": too small to be a block store" << std::endl;
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Failed to mmap " << path << std::endl;
+        return false;
+    }
+
+    size_t len = st.st_size;
+    const StoreHeader* header = static_cast<const StoreHeader*>(map);
+    const ColumnEntry* columns = reinterpret_cast<const ColumnEntry*>(header + 1);
+    const char* error = nullptr;
+    if (memcmp(header->magic, STORE_MAGIC, sizeof(header->magic)) != 0) {
+        error = "bad magic";
+    } else if (header->version != STORE_VERSION) {
+        error = "unsupported schema version (re-run txt2db.out)";
+    } else if (header->column_count > (len - sizeof(StoreHeader)) / sizeof(ColumnEntry)) {
+        error = "truncated column directory";
+    } else {
+        for (uint32_t c = 0; c < header->column_count && !error; ++c) {
+            const ColumnEntry& col = columns[c];
+            if (col.offset % 8 != 0 || col.offset > len || col.length > len - col.offset) {
+                error = "column out of bounds";
+            } else if (col.id != COL_RELAYED_POOL && col.length != header->count * col.width) {
+                error = "column length does not match block count";
+            }
+        }
+    }
+    if (error) {
+        std::cerr << path << ": " << error << std::endl;
+        munmap(map, len);
+        return false;
+    }
+
+    map_ = map;
+    map_len_ = len;
+    header_ = header;
+    columns_ = columns;
+    count_ = header->count;
+    return true;
+}
+
+void BlockStore::close() {
+    if (map_) {
+        munmap(map_, map_len_);
+    }
+    map_ = nullptr;
+    map_len_ = 0;
+    header_ = nullptr;
+    columns_ = nullptr;
+    count_ = 0;
+}
+
+const void* BlockStore::column(uint32_t id, uint32_t width, size_t* length) const {
+    if (!map_) return nullptr;
+    for (uint32_t c = 0; c < header_->column_count; ++c) {
+        if (columns_[c].id == id && columns_[c].width == width) {
+            if (length) *length = columns_[c].length;
+            return static_cast<const char*>(map_) + columns_[c].offset;
+        }
+    }
+    return nullptr;
+}
+
+bool BlockStore::verify() const {
+    if (!map_) return false;
+    return crc32(0, header_ + 1, map_len_ - sizeof(StoreHeader)) == header_->checksum;
+}
+
+// Standard reflected CRC-32 (polynomial 0xEDB88320), slicing-by-8: eight
+// bytes per step through eight 256-entry tables, several times faster than a
+// byte at a time. That matters once every decoded segment is checked (see
+// segstore.h). The tables are built at load time, so concurrent first calls
+// don't race.
+struct Crc32Tables {
+    uint32_t t[8][256];
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int s = 1; s < 8; ++s)
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+static const Crc32Tables crc_tables;
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len) {
+    const uint32_t (*t)[256] = crc_tables.t;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;  // little-endian: the first four bytes are the low ones
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; len > 0; ++p, --len)
+        crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+bool read_store_count(const std::string& path, uint64_t* count) {
+    std::ifstream file(path, std::ios::binary);
+    StoreHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != STORE_VERSION) {
+        return false;
+    }
+    *count = header.count;
+    return true;
+}
+
+// Writes `len` bytes and pads with zeros to the next 8-byte boundary,
+// updating the running checksum and file offset.
+static void write_padded(std::ofstream& out, const void* data, size_t len,
+                         uint32_t* checksum, uint64_t* offset) {
+    static const char zeros[8] = {0};
+    size_t pad = (8 - len % 8) % 8;
+    out.write(static_cast<const char*>(data), len);
+    out.write(zeros, pad);
+    *checksum = crc32(*checksum, data, len);
+    *checksum = crc32(*checksum, zeros, pad);
+    *offset += len + pad;
+}
+
+bool save_store(const BlockTable& table, const std::string& db_path) {
+    std::string pool;
+    for (size_t i = 0; i < table.relayed_dict().size(); ++i) {
+        pool += table.relayed_dict().get((uint32_t)i);
+        pool += '\0';
+    }
+
+    size_t n = table.size();
+    struct { uint32_t id; uint32_t width; const void* data; size_t length; } cols[] = {
+        {COL_HASH, sizeof(Hash32), table.hashes(), n * sizeof(Hash32)},
+        {COL_PREV_BLOCK, sizeof(Hash32), table.prev_blocks(), n * sizeof(Hash32)},
+        {COL_HEIGHT, sizeof(int32_t), table.heights(), n * sizeof(int32_t)},
+        {COL_TOTAL, sizeof(int64_t), table.totals(), n * sizeof(int64_t)},
+        {COL_TIME, sizeof(int64_t), table.times(), n * sizeof(int64_t)},
+        {COL_RELAYED_BY, sizeof(uint32_t), table.relayed_ids(), n * sizeof(uint32_t)},
+        {COL_RELAYED_POOL, 1, pool.data(), pool.size()},
+        {COL_N_TX, sizeof(int32_t), table.n_txs(), n * sizeof(int32_t)},
+        {COL_FEES, sizeof(int64_t), table.fees(), n * sizeof(int64_t)},
+        {COL_SIZE, sizeof(int32_t), table.sizes(), n * sizeof(int32_t)},
+    };
+    const uint32_t ncols = sizeof(cols) / sizeof(cols[0]);
+
+    StoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.version = STORE_VERSION;
+    header.column_count = ncols;
+    header.count = n;
+
+    std::vector<ColumnEntry> dir(ncols);
+    uint64_t offset = sizeof(StoreHeader) + ncols * sizeof(ColumnEntry);
+    for (uint32_t c = 0; c < ncols; ++c) {
+        dir[c].id = cols[c].id;
+        dir[c].width = cols[c].width;
+        dir[c].offset = offset;
+        dir[c].length = cols[c].length;
+        offset += (cols[c].length + 7) / 8 * 8;
+    }
+
+    std::string tmp_path = db_path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create " << tmp_path << std::endl;
+        return false;
+    }
+
+    // The directory size is a multiple of 8, so column data starts aligned.
+    uint32_t checksum = 0;
+    offset = sizeof(StoreHeader);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_padded(out, dir.data(), dir.size() * sizeof(ColumnEntry), &checksum, &offset);
+    for (uint32_t c = 0; c < ncols; ++c) {
+        write_padded(out, cols[c].data, cols[c].length, &checksum, &offset);
+    }
+
+    header.checksum = checksum;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write " << tmp_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(tmp_path.c_str(), db_path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << tmp_path << " to " << db_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool convert_txt_to_store(const std::string& txt_path, const std::string& db_path) {
+    BlockTable table;
+    if (!load_txt(txt_path, table)) {
+        std::cerr << "Failed to open " << txt_path << std::endl;
+        return false;
+    }
+    return save_store(table, db_path);
+}
+
+bool convert_json_to_store(const std::string& json_path, const std::string& db_path, uint32_t fields) {
+    BlockTable table;
+    ParseReport report;
+    if (!parse_json_file(json_path, fields, table, &report)) {
+        std::cerr << "Failed to open " << json_path << std::endl;
+        return false;
+    }
+    if (report.skipped > 0) {
+        std::cerr << json_path << ": skipped " << report.skipped << " malformed document(s)";
+        if (!report.issues.empty()) {
+            std::cerr << ", first at line " << report.issues[0].line << ": " << report.issues[0].message;
+        }
+        std::cerr << std::endl;
+    }
+    return save_store(table, db_path);
+}
+
+bool convert_csv_to_store(const std::string& csv_path, const std::string& db_path) {
+    BlockTable table;
+    ParseReport report;
+    if (!parse_csv_file(csv_path, table, &report)) {
+        return false;
+    }
+    if (report.skipped > 0) {
+        std::cerr << csv_path << ": skipped " << report.skipped << " malformed row(s)";
+        if (!report.issues.empty()) {
+            std::cerr << ", first at line " << report.issues[0].line << ": " << report.issues[0].message;
+        }
+        std::cerr << std::endl;
+    }
+    return save_store(table, db_path);
+}
@@ -0,0 +1,105 @@
+#ifndef BLOCKSTORE_H
+#define BLOCKSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "chain.h"
+
+// Binary block store (info.db).
+// Layout: StoreHeader, then `column_count` ColumnEntry descriptors, then the
+// column data. Every column is an array of fixed-width values (one per block)
+// starting on an 8-byte boundary, so a BlockTable can use the mapping as is.
+// All integers are stored in host (little-endian) byte order.
+//
+// Version history:
+//   1 - row-oriented 160-byte records (text time and relayed_by)
+//   2 - column-oriented, epoch times, dictionary-encoded relayed_by
+// Columns may be added within a version: readers skip ids they don't know
+// and treat missing optional columns (8 and up) as unknown values.
+
+#define STORE_MAGIC "BLKSTORE"
+#define STORE_VERSION 2
+#define STORE_FILE "info.db"
+
+enum StoreColumn {
+    COL_HASH = 1,           // Hash32 per block
+    COL_PREV_BLOCK = 2,     // Hash32 per block
+    COL_HEIGHT = 3,         // int32 per block
+    COL_TOTAL = 4,          // int64 per block
+    COL_TIME = 5,           // int64 epoch seconds per block
+    COL_RELAYED_BY = 6,     // uint32 dictionary id per block
+    COL_RELAYED_POOL = 7,   // dictionary strings, NUL separated, in id order
+    COL_N_TX = 8,           // int32 per block, -1 if unknown (optional)
+    COL_FEES = 9,           // int64 per block, -1 if unknown (optional)
+    COL_SIZE = 10,          // int32 per block, -1 if unknown (optional)
+};
+
+struct StoreHeader {
+    char magic[8];          // "BLKSTORE" (not NUL terminated)
+    uint32_t version;       // STORE_VERSION
+    uint32_t column_count;  // number of ColumnEntry descriptors
+    uint64_t count;         // number of blocks
+    uint32_t checksum;      // CRC-32 of everything after the header
+    uint32_t reserved;
+};
+
+struct ColumnEntry {
+    uint32_t id;            // StoreColumn
+    uint32_t width;         // bytes per value
+    uint64_t offset;        // from the start of the file
+    uint64_t length;        // bytes
+};
+
+static_assert(sizeof(StoreHeader) == 32, "StoreHeader must stay 32 bytes");
+static_assert(sizeof(ColumnEntry) == 24, "ColumnEntry must stay 24 bytes");
+
+// Read-only mmap of an info.db file. Opening only validates the header and
+// the column directory, so it costs the same for 10 blocks or 10 million.
+class BlockStore {
+public:
+    BlockStore();
+    ~BlockStore();
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return map_ != nullptr; }
+    size_t size() const { return count_; }
+
+    // Returns the column data, or nullptr if it's missing or has another width.
+    const void* column(uint32_t id, uint32_t width, size_t* length = nullptr) const;
+
+    // Recomputes the CRC-32 over the file and compares it with the header.
+    bool verify() const;
+
+private:
+    BlockStore(const BlockStore&);
+    BlockStore& operator=(const BlockStore&);
+
+    void* map_;
+    size_t map_len_;
+    const StoreHeader* header_;
+    const ColumnEntry* columns_;
+    size_t count_;
+};
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len);
+
+// Returns true (and the block count) if `path` starts with a valid store header.
+bool read_store_count(const std::string& path, uint64_t* count);
+
+// Writes `table` as a store. The output goes to a temporary file that is
+// renamed into place, so readers never map a half-written store.
+bool save_store(const BlockTable& table, const std::string& db_path);
+
+// One-shot conversion of a text info.txt into a binary info.db.
+bool convert_txt_to_store(const std::string& txt_path, const std::string& db_path);
+
+// Same for BlockCypher JSON documents (single, array or NDJSON), keeping
+// only `fields` (see json.h).
+bool convert_json_to_store(const std::string& json_path, const std::string& db_path, uint32_t fields);
+
+// Same for CSV written by ex3.out (see csvimport.h), parsed on every core.
+bool convert_csv_to_store(const std::string& csv_path, const std::string& db_path);
+
+#endif // BLOCKSTORE_H
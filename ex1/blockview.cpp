@@ -0,0 +1,148 @@
+#include "blockview.h"
+#include "infra.h"
+#include "snapshot.h"
+#include <charconv>
+
+BlockQuery::BlockQuery() : snap_(chain_snapshot()) {}
+
+BlockQuery::BlockQuery(std::shared_ptr<const ChainSnapshot> snapshot) : snap_(std::move(snapshot)) {}
+
+const BlockTable& BlockQuery::table() const {
+    return snap_->table();
+}
+
+size_t BlockQuery::size() const {
+    return snap_->size();
+}
+
+bool BlockQuery::find_hash(std::string_view hex, BlockRef* out) const {
+    size_t row;
+    if (!snap_->find_hash(hex, &row)) return false;
+    *out = at(row);
+    return true;
+}
+
+bool BlockQuery::find_height(int height, BlockRef* out) const {
+    size_t row;
+    if (!snap_->find_height(height, &row)) return false;
+    *out = at(row);
+    return true;
+}
+
+BlockRange BlockQuery::all() const {
+    return BlockRange(table(), nullptr, size());
+}
+
+BlockRange BlockQuery::heights(int from, int to) const {
+    const uint32_t* begin;
+    const uint32_t* end;
+    snap_->ranges().rows(from, to, &begin, &end);
+    return BlockRange(table(), begin, end - begin);
+}
+
+BlockFormatter::BlockFormatter(std::ostream& out, size_t flush_bytes) : out_(out), flush_bytes_(flush_bytes) {}
+
+BlockFormatter::~BlockFormatter() {
+    flush();
+}
+
+BlockFormatter& BlockFormatter::number(int64_t value) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer_.append(digits, end - digits);
+    return *this;
+}
+
+BlockFormatter& BlockFormatter::hex(const Hash32& hash) {
+    size_t used = buffer_.size();
+    buffer_.resize(used + 64);
+    to_hex(hash.bytes, 32, &buffer_[used]);
+    return *this;
+}
+
+BlockFormatter& BlockFormatter::iso_time(int64_t epoch) {
+    char text[ISO_TIME_MAX];
+    buffer_.append(text, format_iso_time(epoch, text));
+    return *this;
+}
+
+void BlockFormatter::block(const BlockRef& b) {
+    *this << "hash: ";
+    hex(b.hash()).line();
+    *this << "height: " << b.height();
+    line();
+    *this << "total: " << b.total();
+    line();
+    *this << "time: ";
+    iso_time(b.time()).line();
+    *this << "relayed_by: " << b.relayed_by();
+    line();
+    *this << "prev_block: ";
+    hex(b.prev_block()).line();
+}
+
+void BlockFormatter::write() {
+    out_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void BlockFormatter::flush() {
+    write();
+    out_.flush();
+}
+
+// The C interface from infra.h: a handle owns one reference to a snapshot.
+struct InfraSnapshot {
+    BlockQuery query;
+};
+
+static void fill_block(const BlockRef& b, InfraBlock* out) {
+    out->hash = b.hash().bytes;
+    out->prev_block = b.prev_block().bytes;
+    out->relayed_by = b.relayed_by().c_str();
+    out->total = b.total();
+    out->time = b.time();
+    out->fees = b.fees();
+    out->height = b.height();
+    out->n_tx = b.n_tx();
+    out->size = b.size_bytes();
+    out->row = (uint32_t)b.row();
+}
+
+InfraSnapshot* infra_acquire(void) {
+    return new InfraSnapshot();
+}
+
+void infra_release(InfraSnapshot* snapshot) {
+    delete snapshot;
+}
+
+size_t infra_block_count(const InfraSnapshot* snapshot) {
+    return snapshot->query.size();
+}
+
+int infra_block_at(const InfraSnapshot* snapshot, size_t row, InfraBlock* out) {
+    if (row >= snapshot->query.size()) return 0;
+    fill_block(snapshot->query.at(row), out);
+    return 1;
+}
+
+int infra_find_hash(const InfraSnapshot* snapshot, const char* hex, InfraBlock* out) {
+    BlockRef b;
+    if (!snapshot->query.find_hash(hex, &b)) return 0;
+    fill_block(b, out);
+    return 1;
+}
+
+int infra_find_height(const InfraSnapshot* snapshot, int height, InfraBlock* out) {
+    BlockRef b;
+    if (!snapshot->query.find_height(height, &b)) return 0;
+    fill_block(b, out);
+    return 1;
+}
+
+size_t infra_height_range(const InfraSnapshot* snapshot, int from, int to, const uint32_t** rows) {
+    const uint32_t* end;
+    snapshot->query.snapshot().ranges().rows(from, to, rows, &end);
+    return end - *rows;
+}
@@ -0,0 +1,156 @@
+#ifndef BLOCKVIEW_H
+#define BLOCKVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "chain.h"
+
+class ChainSnapshot;
+
+// Result-returning access to the loaded chain, for code that embeds
+// libinfra and wants values rather than text on stdout.
+//
+// A BlockQuery pins one snapshot (see snapshot.h); everything it hands out
+// refers into that snapshot's columns without copying, and stays valid for
+// as long as the BlockQuery (or a copy of it) is alive, whatever reloads
+// happen meanwhile. The print_* / find_block_* functions in infra.h are
+// this plus a BlockFormatter.
+
+// One block of a snapshot. Accessors read the columns directly.
+class BlockRef {
+public:
+    BlockRef() : table_(nullptr), row_(0) {}
+    BlockRef(const BlockTable& table, size_t row) : table_(&table), row_(row) {}
+
+    size_t row() const { return row_; }
+    const Hash32& hash() const { return table_->hash(row_); }
+    const Hash32& prev_block() const { return table_->prev_block(row_); }
+    int height() const { return table_->height(row_); }
+    int64_t total() const { return table_->total(row_); }
+    int64_t time() const { return table_->time(row_); }
+    const std::string& relayed_by() const { return table_->relayed_by(row_); }
+    int n_tx() const { return table_->n_tx(row_); }
+    int64_t fees() const { return table_->fee(row_); }
+    int size_bytes() const { return table_->size_bytes(row_); }
+
+private:
+    const BlockTable* table_;
+    size_t row_;
+};
+
+// A sequence of blocks: either every row in load order, or a span of rows
+// (e.g. a height range in height order, straight out of the range index).
+class BlockRange {
+public:
+    class iterator {
+    public:
+        iterator(const BlockTable* table, const uint32_t* rows, size_t pos)
+            : table_(table), rows_(rows), pos_(pos) {}
+        BlockRef operator*() const { return BlockRef(*table_, rows_ ? rows_[pos_] : pos_); }
+        iterator& operator++() {
+            ++pos_;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return pos_ == other.pos_; }
+        bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
+
+    private:
+        const BlockTable* table_;
+        const uint32_t* rows_;  // null: row == position
+        size_t pos_;
+    };
+
+    BlockRange(const BlockTable& table, const uint32_t* rows, size_t count)
+        : table_(&table), rows_(rows), count_(count) {}
+
+    iterator begin() const { return iterator(table_, rows_, 0); }
+    iterator end() const { return iterator(table_, rows_, count_); }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    BlockRef operator[](size_t i) const { return BlockRef(*table_, rows_ ? rows_[i] : i); }
+
+private:
+    const BlockTable* table_;
+    const uint32_t* rows_;
+    size_t count_;
+};
+
+class BlockQuery {
+public:
+    BlockQuery();  // the current snapshot
+    explicit BlockQuery(std::shared_ptr<const ChainSnapshot> snapshot);
+
+    const ChainSnapshot& snapshot() const { return *snap_; }
+    const BlockTable& table() const;
+    size_t size() const;
+
+    BlockRef at(size_t row) const { return BlockRef(table(), row); }
+    bool find_hash(std::string_view hex, BlockRef* out) const;
+    bool find_height(int height, BlockRef* out) const;
+
+    // Every block, in load order.
+    BlockRange all() const;
+    // Blocks with from <= height <= to, in height order (builds the range
+    // index on first use, like query_range()).
+    BlockRange heights(int from, int to) const;
+
+private:
+    std::shared_ptr<const ChainSnapshot> snap_;
+};
+
+// Buffered text output for the printing functions: values are formatted
+// straight into one buffer (to_chars, to_hex, format_iso_time) and handed
+// to the stream in large writes, instead of a flushed std::endl per line.
+// Whatever is left is written, and the stream flushed, by flush() or the
+// destructor, so output still appears before the printing function returns.
+class BlockFormatter {
+public:
+    explicit BlockFormatter(std::ostream& out = std::cout, size_t flush_bytes = 64 * 1024);
+    ~BlockFormatter();
+
+    BlockFormatter(const BlockFormatter&) = delete;
+    BlockFormatter& operator=(const BlockFormatter&) = delete;
+
+    BlockFormatter& operator<<(std::string_view text) {
+        buffer_.append(text.data(), text.size());
+        return *this;
+    }
+    BlockFormatter& operator<<(const char* text) { return *this << std::string_view(text); }
+    BlockFormatter& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    BlockFormatter& operator<<(char c) {
+        buffer_ += c;
+        return *this;
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    BlockFormatter& operator<<(T value) {
+        return number((int64_t)value);
+    }
+
+    BlockFormatter& number(int64_t value);
+    BlockFormatter& hex(const Hash32& hash);
+    BlockFormatter& iso_time(int64_t epoch);
+
+    // The six "name: value" lines print_db() and find_block_*() show.
+    void block(const BlockRef& b);
+    // Ends a line; writes the buffer out once it holds flush_bytes.
+    void line() {
+        buffer_ += '\n';
+        if (buffer_.size() >= flush_bytes_) write();
+    }
+
+    void flush();
+
+private:
+    void write();
+
+    std::ostream& out_;
+    size_t flush_bytes_;
+    std::string buffer_;
+};
+
+#endif // BLOCKVIEW_H
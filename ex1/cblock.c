@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "infra_c.h"
+
+// C client of libinfra (infra_c.h): looks a block up by height or hash,
+// or takes the newest one loaded, and prints its fields.
+//
+// Usage: cblock.out [<height> | <hash>]
+
+static void print_hex(const uint8_t* bytes) {
+    for (int i = 0; i < 32; ++i) printf("%02x", bytes[i]);
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        printf("Usage: %s [<height> | <hash>]\n", argv[0]);
+        return 1;
+    }
+    load_db();
+    InfraSnapshot* snapshot = infra_acquire();
+    InfraBlock block;
+    int found;
+    if (argc == 1) {
+        size_t count = infra_block_count(snapshot);
+        found = count > 0 && infra_block_at(snapshot, count - 1, &block);
+    } else if (strlen(argv[1]) == 64) {
+        found = infra_find_hash(snapshot, argv[1], &block);
+    } else {
+        found = infra_find_height(snapshot, atoi(argv[1]), &block);
+    }
+    if (found) {
+        printf("Hash: ");
+        print_hex(block.hash);
+        printf("Height: %d\nTotal: %lld\nTime: %lld\nRelayed By: %s\nPrevious Block: ", block.height,
+               (long long)block.total, (long long)block.time, block.relayed_by);
+        print_hex(block.prev_block);
+    } else {
+        printf("Block not found.\n");
+    }
+    infra_release(snapshot);
+    return found ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+#include "chain.h"
+#include "blockstore.h"
+#include <cstdio>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+std::string to_hex(const uint8_t* data, size_t len) {
+    std::string out(len * 2, '0');
+    to_hex(data, len, &out[0]);
+    return out;
+}
+
+// 16 bytes at a time with SSE2: split into nibbles, interleave them and
+// map 0-15 to '0'-'9'/'a'-'f' with one compare. Exports and printing call
+// this twice per block.
+void to_hex(const uint8_t* data, size_t len, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i gap = _mm_set1_epi8('a' - '0' - 10);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i lo = _mm_and_si128(v, mask);
+        __m128i first = _mm_unpacklo_epi8(hi, lo);
+        __m128i second = _mm_unpackhi_epi8(hi, lo);
+        first = _mm_add_epi8(_mm_add_epi8(first, zero), _mm_and_si128(_mm_cmpgt_epi8(first, nine), gap));
+        second = _mm_add_epi8(_mm_add_epi8(second, zero), _mm_and_si128(_mm_cmpgt_epi8(second, nine), gap));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), first);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), second);
+    }
+#endif
+    for (; i < len; ++i) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+}
+
+// Nibble value of every byte, 0xFF for non-hex characters.
+struct HexTable {
+    uint8_t value[256];
+    HexTable() {
+        for (int c = 0; c < 256; ++c) value[c] = 0xFF;
+        for (int c = 0; c < 10; ++c) value['0' + c] = (uint8_t)c;
+        for (int c = 0; c < 6; ++c) value['a' + c] = value['A' + c] = (uint8_t)(10 + c);
+    }
+};
+static const HexTable hex_table;
+
+bool from_hex(std::string_view hex, uint8_t* out, size_t len) {
+    if (hex.size() != len * 2) return false;
+    uint8_t bad = 0;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t hi = hex_table.value[(uint8_t)hex[2 * i]];
+        uint8_t lo = hex_table.value[(uint8_t)hex[2 * i + 1]];
+        bad |= (hi | lo) & 0xF0;  // Checked once at the end, keeps the loop branch-free
+        out[i] = (uint8_t)((hi << 4) | (lo & 0x0F));
+    }
+    return bad == 0;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm).
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t* y, unsigned* m, unsigned* d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static bool read_digits(const char* p, int n, int* out) {
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+bool parse_iso_time(std::string_view text, int64_t* out) {
+    // 2024-06-10T08:49:40Z, optionally with fractional seconds (dropped)
+    const char* s = text.data();
+    if (text.size() < 20 || s[4] != '-' || s[7] != '-' || s[10] != 'T' ||
+        s[13] != ':' || s[16] != ':') {
+        return false;
+    }
+    int year, month, day, hour, minute, second;
+    if (!read_digits(s, 4, &year) || !read_digits(s + 5, 2, &month) ||
+        !read_digits(s + 8, 2, &day) || !read_digits(s + 11, 2, &hour) ||
+        !read_digits(s + 14, 2, &minute) || !read_digits(s + 17, 2, &second)) {
+        return false;
+    }
+    size_t pos = 19;
+    if (pos < text.size() && s[pos] == '.') {
+        ++pos;
+        while (pos < text.size() && s[pos] >= '0' && s[pos] <= '9') ++pos;
+    }
+    if (pos + 1 != text.size() || s[pos] != 'Z') return false;
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    *out = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+std::string format_iso_time(int64_t epoch) {
+    char buf[ISO_TIME_MAX];
+    return std::string(buf, format_iso_time(epoch, buf));
+}
+
+static void put_2digits(char* out, unsigned v) {
+    out[0] = (char)('0' + v / 10);
+    out[1] = (char)('0' + v % 10);
+}
+
+size_t format_iso_time(int64_t epoch, char* out) {
+    int64_t days = epoch >= 0 ? epoch / 86400 : -((-epoch + 86399) / 86400);
+    int64_t secs = epoch - days * 86400;
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(days, &year, &month, &day);
+    if (year < 0 || year > 9999) {
+        char buf[64];
+        int n = snprintf(buf, sizeof(buf), "%04lld-%02u-%02uT%02d:%02d:%02dZ", (long long)year, month, day,
+                         (int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+        n = n < ISO_TIME_MAX ? n : ISO_TIME_MAX;
+        memcpy(out, buf, n);
+        return n;
+    }
+    // Fixed layout, filled in place: this runs once per row of an export.
+    memcpy(out, "0000-00-00T00:00:00Z", 20);
+    put_2digits(out, (unsigned)(year / 100));
+    put_2digits(out + 2, (unsigned)(year % 100));
+    put_2digits(out + 5, month);
+    put_2digits(out + 8, day);
+    put_2digits(out + 11, (unsigned)(secs / 3600));
+    put_2digits(out + 14, (unsigned)(secs / 60 % 60));
+    put_2digits(out + 17, (unsigned)(secs % 60));
+    return 20;
+}
+
+const std::string& StringDict::get(uint32_t id) const {
+    static const std::string unknown;
+    return id < strings_.size() ? strings_[id] : unknown;
+}
+
+StringDict& StringDict::operator=(const StringDict& other) {
+    if (this != &other) {
+        clear();
+        for (const auto& s : other.strings_) intern(s);
+    }
+    return *this;
+}
+
+uint32_t StringDict::intern(std::string_view s) {
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+    uint32_t id = (uint32_t)strings_.size();
+    strings_.emplace_back(s);
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+void StringDict::clear() {
+    strings_.clear();
+    ids_.clear();
+}
+
+void BlockTable::clear() {
+    hashes_.clear();
+    prev_blocks_.clear();
+    heights_.clear();
+    totals_.clear();
+    times_.clear();
+    relayed_ids_.clear();
+    n_txs_.clear();
+    fees_.clear();
+    sizes_.clear();
+    relayed_dict_.clear();
+    backing_.reset();
+}
+
+void BlockTable::reserve(size_t n) {
+    hashes_.reserve(n);
+    prev_blocks_.reserve(n);
+    heights_.reserve(n);
+    totals_.reserve(n);
+    times_.reserve(n);
+    relayed_ids_.reserve(n);
+    n_txs_.reserve(n);
+    fees_.reserve(n);
+    sizes_.reserve(n);
+}
+
+bool BlockTable::append(const Block& b) {
+    Hash32 hash, prev;
+    int64_t time;
+    if (!from_hex(b.hash, hash.bytes, 32) || !from_hex(b.prev_block, prev.bytes, 32) ||
+        !parse_iso_time(b.time, &time)) {
+        return false;
+    }
+    append(hash, b.height, b.total, time, b.relayed_by, prev, b.n_tx, b.fees, b.size);
+    return true;
+}
+
+void BlockTable::append(const Hash32& hash, int height, int64_t total, int64_t time,
+                        std::string_view relayed_by, const Hash32& prev_block,
+                        int n_tx, int64_t fees, int size) {
+    hashes_.push_back(hash);
+    prev_blocks_.push_back(prev_block);
+    heights_.push_back(height);
+    totals_.push_back(total);
+    times_.push_back(time);
+    relayed_ids_.push_back(relayed_dict_.intern(relayed_by));
+    n_txs_.push_back(n_tx);
+    fees_.push_back(fees);
+    sizes_.push_back(size);
+}
+
+void BlockTable::append(const BlockTable& other) {
+    size_t n = other.size();
+    std::vector<uint32_t> ids(other.relayed_dict_.size());
+    for (size_t id = 0; id < ids.size(); ++id) {
+        ids[id] = relayed_dict_.intern(other.relayed_dict_.get((uint32_t)id));
+    }
+    std::vector<uint32_t> relayed(n);
+    for (size_t i = 0; i < n; ++i) {
+        relayed[i] = ids[other.relayed_ids_[i]];
+    }
+    hashes_.append(other.hashes(), n);
+    prev_blocks_.append(other.prev_blocks(), n);
+    heights_.append(other.heights(), n);
+    totals_.append(other.totals(), n);
+    times_.append(other.times(), n);
+    relayed_ids_.append(relayed.data(), n);
+    n_txs_.append(other.n_txs(), n);
+    fees_.append(other.fees(), n);
+    sizes_.append(other.sizes(), n);
+}
+
+template <typename T>
+static void attach_or_fill(Column<T>& column, const void* data, size_t n) {
+    if (data) {
+        column.attach(static_cast<const T*>(data), n);
+        return;
+    }
+    column.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        column.push_back(-1);
+    }
+}
+
+// Points every column at the mapped store. Only the relayed_by dictionary
+// (a handful of strings) is copied. Stores written before the n_tx/fees/size
+// columns existed get those columns filled with -1.
+bool BlockTable::attach(const std::shared_ptr<const BlockStore>& store) {
+    clear();
+    size_t n = store->size();
+    const void* cols[6];
+    const int ids[6] = {COL_HASH, COL_PREV_BLOCK, COL_HEIGHT, COL_TOTAL, COL_TIME, COL_RELAYED_BY};
+    const size_t widths[6] = {sizeof(Hash32), sizeof(Hash32), sizeof(int32_t),
+                              sizeof(int64_t), sizeof(int64_t), sizeof(uint32_t)};
+    for (int c = 0; c < 6; ++c) {
+        cols[c] = store->column(ids[c], widths[c]);
+        if (!cols[c] && n > 0) return false;
+    }
+
+    size_t pool_len = 0;
+    const char* pool = static_cast<const char*>(store->column(COL_RELAYED_POOL, 1, &pool_len));
+    for (size_t pos = 0; pool && pos < pool_len;) {
+        size_t len = strnlen(pool + pos, pool_len - pos);
+        relayed_dict_.intern(std::string_view(pool + pos, len));
+        pos += len + 1;
+    }
+
+    hashes_.attach(static_cast<const Hash32*>(cols[0]), n);
+    prev_blocks_.attach(static_cast<const Hash32*>(cols[1]), n);
+    heights_.attach(static_cast<const int32_t*>(cols[2]), n);
+    totals_.attach(static_cast<const int64_t*>(cols[3]), n);
+    times_.attach(static_cast<const int64_t*>(cols[4]), n);
+    relayed_ids_.attach(static_cast<const uint32_t*>(cols[5]), n);
+    attach_or_fill(n_txs_, store->column(COL_N_TX, sizeof(int32_t)), n);
+    attach_or_fill(fees_, store->column(COL_FEES, sizeof(int64_t)), n);
+    attach_or_fill(sizes_, store->column(COL_SIZE, sizeof(int32_t)), n);
+    backing_ = store;
+    return true;
+}
+
+Block BlockTable::block(size_t i) const {
+    Block b;
+    b.hash = hash_hex(i);
+    b.height = height(i);
+    b.total = total(i);
+    b.time = time_iso(i);
+    b.relayed_by = relayed_by(i);
+    b.prev_block = prev_block_hex(i);
+    b.n_tx = n_tx(i);
+    b.fees = fee(i);
+    b.size = size_bytes(i);
+    return b;
+}
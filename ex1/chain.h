@@ -0,0 +1,201 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A block as text, the way info.txt and the printed output show it.
+// Only used at the edges (parsing and printing); the loaded chain is
+// kept in the compact BlockTable below.
+struct Block {
+    std::string hash;
+    int height;
+    int64_t total;  // Changed from int to int64_t
+    std::string time;
+    std::string relayed_by;
+    std::string prev_block;
+    // Only present in full API documents (not in info.txt); -1 if unknown.
+    int n_tx = -1;
+    int64_t fees = -1;
+    int size = -1;
+};
+
+// Raw 32-byte block hash, in the same byte order as its hex string.
+struct Hash32 {
+    uint8_t bytes[32];
+};
+
+std::string to_hex(const uint8_t* data, size_t len);
+// Writes the 2 * len hex digits to `out` (no NUL), for bulk output.
+void to_hex(const uint8_t* data, size_t len, char* out);
+bool from_hex(std::string_view hex, uint8_t* out, size_t len);
+
+// "YYYY-MM-DDTHH:MM:SS[.fff]Z" <-> seconds since the Unix epoch (UTC).
+bool parse_iso_time(std::string_view text, int64_t* out);
+std::string format_iso_time(int64_t epoch);
+// Same into `out` (room for ISO_TIME_MAX chars, no NUL); returns the length.
+#define ISO_TIME_MAX 32
+size_t format_iso_time(int64_t epoch, char* out);
+
+// Column storage: either owned by a vector or a read-only view into a
+// memory-mapped store. Appending to a view copies it first.
+template <typename T>
+class Column {
+public:
+    Column() : data_(nullptr), size_(0) {}
+    Column(const Column& other) { *this = other; }
+    Column& operator=(const Column& other) {
+        owned_ = other.owned_;
+        data_ = other.is_view() ? other.data_ : owned_.data();
+        size_ = other.size_;
+        return *this;
+    }
+    // Moving keeps the buffer (owned or mapped) where it is.
+    Column(Column&& other) noexcept { *this = std::move(other); }
+    Column& operator=(Column&& other) noexcept {
+        owned_ = std::move(other.owned_);
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        return *this;
+    }
+
+    void clear() {
+        std::vector<T>().swap(owned_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+    void reserve(size_t n) {
+        detach();
+        owned_.reserve(n);
+        data_ = owned_.data();
+    }
+    void push_back(const T& value) {
+        detach();
+        owned_.push_back(value);
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+    void append(const T* values, size_t n) {
+        detach();
+        owned_.insert(owned_.end(), values, values + n);
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+    void attach(const T* data, size_t n) {
+        std::vector<T>().swap(owned_);
+        data_ = data;
+        size_ = n;
+    }
+
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    bool is_view() const { return size_ != 0 && data_ != owned_.data(); }
+
+private:
+    void detach() {
+        if (is_view()) {
+            owned_.assign(data_, data_ + size_);
+            data_ = owned_.data();
+        }
+    }
+
+    std::vector<T> owned_;
+    const T* data_;
+    size_t size_;
+};
+
+// Interns repeated strings (relayed_by has only a handful of distinct values).
+class StringDict {
+public:
+    StringDict() {}
+    StringDict(const StringDict& other) { *this = other; }
+    StringDict& operator=(const StringDict& other);
+
+    // Allocates only the first time a string is seen.
+    uint32_t intern(std::string_view s);
+    const std::string& get(uint32_t id) const;  // "" for an unknown id
+    size_t size() const { return strings_.size(); }
+    void clear();
+
+private:
+    std::deque<std::string> strings_;  // deque: element addresses never move
+    std::unordered_map<std::string_view, uint32_t> ids_;  // views into strings_
+};
+
+class BlockStore;
+
+// The loaded chain as a structure of arrays: one contiguous column per field,
+// binary hashes, epoch timestamps and dictionary ids for relayed_by.
+// About 104 bytes per block and no per-block heap allocations.
+class BlockTable {
+public:
+    size_t size() const { return heights_.size(); }
+    bool empty() const { return size() == 0; }
+    void clear();
+    void reserve(size_t n);
+
+    // Returns false (and appends nothing) if the hash or time is malformed.
+    bool append(const Block& b);
+    void append(const Hash32& hash, int height, int64_t total, int64_t time,
+                std::string_view relayed_by, const Hash32& prev_block,
+                int n_tx = -1, int64_t fees = -1, int size = -1);
+    // Appends all rows of `other`, a column at a time (relayed_by ids are
+    // mapped into this table's dictionary).
+    void append(const BlockTable& other);
+
+    // Serves the columns straight from a mapped store (no copy).
+    bool attach(const std::shared_ptr<const BlockStore>& store);
+
+    // Column access for scans.
+    const Hash32* hashes() const { return hashes_.data(); }
+    const Hash32* prev_blocks() const { return prev_blocks_.data(); }
+    const int32_t* heights() const { return heights_.data(); }
+    const int64_t* totals() const { return totals_.data(); }
+    const int64_t* times() const { return times_.data(); }
+    const uint32_t* relayed_ids() const { return relayed_ids_.data(); }
+    const StringDict& relayed_dict() const { return relayed_dict_; }
+    const int32_t* n_txs() const { return n_txs_.data(); }
+    const int64_t* fees() const { return fees_.data(); }
+    const int32_t* sizes() const { return sizes_.data(); }
+
+    // Per-block access.
+    const Hash32& hash(size_t i) const { return hashes_[i]; }
+    const Hash32& prev_block(size_t i) const { return prev_blocks_[i]; }
+    int height(size_t i) const { return heights_[i]; }
+    int64_t total(size_t i) const { return totals_[i]; }
+    int64_t time(size_t i) const { return times_[i]; }
+    const std::string& relayed_by(size_t i) const { return relayed_dict_.get(relayed_ids_[i]); }
+    int n_tx(size_t i) const { return n_txs_[i]; }
+    int64_t fee(size_t i) const { return fees_[i]; }
+    int size_bytes(size_t i) const { return sizes_[i]; }
+
+    // Formatting back to text, for output only.
+    std::string hash_hex(size_t i) const { return to_hex(hashes_[i].bytes, 32); }
+    std::string prev_block_hex(size_t i) const { return to_hex(prev_blocks_[i].bytes, 32); }
+    std::string time_iso(size_t i) const { return format_iso_time(times_[i]); }
+    Block block(size_t i) const;
+
+private:
+    Column<Hash32> hashes_;
+    Column<Hash32> prev_blocks_;
+    Column<int32_t> heights_;
+    Column<int64_t> totals_;
+    Column<int64_t> times_;
+    Column<uint32_t> relayed_ids_;
+    Column<int32_t> n_txs_;
+    Column<int64_t> fees_;
+    Column<int32_t> sizes_;
+    StringDict relayed_dict_;
+    std::shared_ptr<const BlockStore> backing_;  // Keeps mapped columns alive
+};
+
+#endif // CHAIN_H
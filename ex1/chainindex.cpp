@@ -0,0 +1,123 @@
+#include "chainindex.h"
+#include <algorithm>
+
+// Marks a row whose depth is being worked out, to stop at prev_block cycles
+// (only possible in corrupt input).
+static const uint32_t VISITING = NO_SLOT - 1;
+
+void ChainIndex::clear() {
+    up_.clear();
+    next_.clear();
+    depth_.clear();
+    report_ = ChainReport();
+}
+
+void ChainIndex::build(const BlockTable& table, const HashIndex& hashes) {
+    clear();
+    size_t n = table.size();
+    report_.blocks = n;
+    if (n == 0) return;
+
+    std::vector<uint32_t> parent(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t p = hashes.find(table.prev_block(i));
+        parent[i] = p == (uint32_t)i ? NO_SLOT : p;
+    }
+
+    // Depths: walk up to the first row with a known depth, then fill in the
+    // path on the way back. Every row is walked once, so this is O(n) in
+    // whatever order the rows were loaded.
+    depth_.assign(n, NO_SLOT);
+    std::vector<uint32_t> path;
+    uint32_t max_depth = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t row = (uint32_t)i;
+        while (row != NO_SLOT && depth_[row] == NO_SLOT) {
+            depth_[row] = VISITING;
+            path.push_back(row);
+            row = parent[row];
+        }
+        if (row != NO_SLOT && depth_[row] == VISITING) {
+            parent[path.back()] = NO_SLOT;  // Cycle: cut it at the last row
+            row = NO_SLOT;
+        }
+        uint32_t d = row == NO_SLOT ? 0 : depth_[row] + 1;
+        for (auto it = path.rbegin(); it != path.rend(); ++it, ++d) {
+            depth_[*it] = d;
+        }
+        if (!path.empty()) max_depth = std::max(max_depth, d - 1);
+        path.clear();
+    }
+
+    // Visit rows deepest first (counting sort by depth) so each row's reach,
+    // the deepest block below it, is final before its parent looks at it.
+    std::vector<uint32_t> start(max_depth + 2, 0);
+    for (size_t i = 0; i < n; ++i) ++start[depth_[i] + 1];
+    for (size_t d = 1; d < start.size(); ++d) start[d] += start[d - 1];
+    std::vector<uint32_t> by_depth(n);
+    for (size_t i = 0; i < n; ++i) by_depth[start[depth_[i]]++] = (uint32_t)i;
+
+    std::vector<uint32_t> reach(depth_);
+    std::vector<uint32_t> children(n, 0);
+    next_.assign(n, NO_SLOT);
+    report_.tip = by_depth[n - 1];
+    for (size_t k = n; k-- > 0;) {
+        uint32_t row = by_depth[k];
+        uint32_t p = parent[row];
+        if (p == NO_SLOT) continue;
+        ++children[p];
+        if (next_[p] == NO_SLOT || reach[row] > reach[next_[p]]) next_[p] = row;
+        reach[p] = std::max(reach[p], reach[row]);
+    }
+
+    // Roots other than the lowest one mean missing blocks (or a stray block
+    // from another chain); more than one child means a fork.
+    uint32_t first_root = NO_SLOT;
+    for (size_t i = 0; i < n; ++i) {
+        if (parent[i] == NO_SLOT) {
+            ++report_.roots;
+            if (first_root == NO_SLOT || table.height(i) < table.height(first_root)) first_root = (uint32_t)i;
+        }
+        if (children[i] > 1) report_.forks.push_back((uint32_t)i);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (parent[i] == NO_SLOT && i != first_root) report_.gaps.push_back((uint32_t)i);
+    }
+
+    // Jump tables: the 2^k-th ancestor is the 2^(k-1)-th ancestor's
+    // 2^(k-1)-th ancestor. Only as many levels as the longest branch needs.
+    up_.push_back(std::move(parent));
+    for (uint32_t span = 2; span <= max_depth && span != 0; span <<= 1) {
+        const std::vector<uint32_t>& half = up_.back();
+        std::vector<uint32_t> level(n);
+        for (size_t i = 0; i < n; ++i) {
+            level[i] = half[i] == NO_SLOT ? NO_SLOT : half[half[i]];
+        }
+        up_.push_back(std::move(level));
+    }
+}
+
+uint32_t ChainIndex::ancestor(size_t row, uint32_t steps) const {
+    if (row >= depth_.size() || steps > depth_[row]) return NO_SLOT;
+    uint32_t cur = (uint32_t)row;
+    for (size_t k = 0; steps != 0; ++k, steps >>= 1) {
+        if (steps & 1) cur = up_[k][cur];
+    }
+    return cur;
+}
+
+uint32_t ChainIndex::common_ancestor(size_t a, size_t b) const {
+    if (a >= depth_.size() || b >= depth_.size()) return NO_SLOT;
+    if (depth_[a] < depth_[b]) std::swap(a, b);
+    uint32_t x = ancestor(a, depth_[a] - depth_[b]);
+    uint32_t y = (uint32_t)b;
+    if (x == y) return x;
+    // Same depth: jump both while they still differ, largest jumps first.
+    for (size_t k = up_.size(); k-- > 0;) {
+        if (up_[k][x] != up_[k][y]) {
+            x = up_[k][x];
+            y = up_[k][y];
+        }
+    }
+    return up_.empty() ? NO_SLOT : up_[0][x];  // NO_SLOT if x and y are roots
+}
@@ -0,0 +1,58 @@
+#ifndef CHAININDEX_H
+#define CHAININDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "chain.h"
+#include "blockindex.h"
+
+// Parent/child links over the loaded chain, for walks such as "the block
+// 10,000 before X" or "is X an ancestor of Y".
+//
+// Blocks only carry their prev_block hash; building resolves it to a row
+// once per block (one hash-index probe) and keeps:
+//   - up_[0][i] / next_[i]: the previous and next row (NO_SLOT at the ends);
+//     after a fork, next_ follows the child whose branch reaches furthest,
+//   - depth_[i]: blocks between i and its oldest loaded ancestor,
+//   - up_[k][i]: the 2^k-th ancestor of i (binary lifting),
+// so ancestor-at-depth and common-ancestor queries take O(log n) jumps.
+// The tables cost 4 bytes per block per level, with one level per bit of
+// the longest branch.
+
+// Where the loaded chain isn't one straight line, found while building.
+struct ChainReport {
+    size_t blocks = 0;
+    size_t roots = 0;              // blocks whose prev_block isn't loaded
+    std::vector<uint32_t> gaps;    // those roots except the lowest one (rows)
+    std::vector<uint32_t> forks;   // rows with two or more children
+    uint32_t tip = NO_SLOT;        // end of the longest branch
+};
+
+class ChainIndex {
+public:
+    void clear();
+    // `hashes` must index the same table.
+    void build(const BlockTable& table, const HashIndex& hashes);
+    size_t size() const { return depth_.size(); }
+    const ChainReport& report() const { return report_; }
+
+    uint32_t parent(size_t row) const { return up_.empty() ? NO_SLOT : up_[0][row]; }
+    uint32_t next(size_t row) const { return next_[row]; }
+    uint32_t depth(size_t row) const { return depth_[row]; }
+
+    // The block `steps` blocks before `row` (0 is `row` itself); NO_SLOT if
+    // that is past the oldest loaded ancestor.
+    uint32_t ancestor(size_t row, uint32_t steps) const;
+    // The newest block both rows descend from (possibly one of them);
+    // NO_SLOT if they don't share a loaded ancestor.
+    uint32_t common_ancestor(size_t a, size_t b) const;
+
+private:
+    std::vector<std::vector<uint32_t>> up_;
+    std::vector<uint32_t> next_;
+    std::vector<uint32_t> depth_;
+    ChainReport report_;
+};
+
+#endif // CHAININDEX_H
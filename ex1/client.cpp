@@ -0,0 +1,87 @@
+#include "client.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+BlockClient::BlockClient() : fd_(-1), pos_(0) {}
+
+BlockClient::~BlockClient() {
+    close();
+}
+
+bool BlockClient::connect(const std::string& socket_path) {
+    close();
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        error_ = "socket path too long";
+        return false;
+    }
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        error_ = "cannot connect to " + socket_path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BlockClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buf_.clear();
+    pos_ = 0;
+}
+
+bool BlockClient::send(const std::string& request) {
+    std::string line = request + "\n";
+    size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t n = ::send(fd_, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error_ = "send failed: " + std::string(strerror(errno));
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+bool BlockClient::receive(std::string* response) {
+    for (;;) {
+        size_t nl = buf_.find('\n', pos_);
+        if (nl != std::string::npos) {
+            response->assign(buf_, pos_, nl - pos_);
+            pos_ = nl + 1;
+            if (pos_ == buf_.size()) {
+                buf_.clear();
+                pos_ = 0;
+            }
+            return true;
+        }
+        if (pos_ > 0) {
+            buf_.erase(0, pos_);
+            pos_ = 0;
+        }
+        char tmp[16384];
+        ssize_t n = recv(fd_, tmp, sizeof(tmp), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error_ = n == 0 ? "server closed the connection" : "receive failed: " + std::string(strerror(errno));
+            return false;
+        }
+        buf_.append(tmp, n);
+    }
+}
+
+bool BlockClient::query(const std::string& request, std::string* response) {
+    return send(request) && receive(response);
+}
@@ -0,0 +1,34 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <string>
+
+// Client side of the query server protocol (see server.h).
+class BlockClient {
+public:
+    BlockClient();
+    ~BlockClient();
+
+    bool connect(const std::string& socket_path);
+    void close();
+
+    // Sends one request line; a newline is added.
+    bool send(const std::string& request);
+    // Reads one response line (without the newline).
+    bool receive(std::string* response);
+    // send() + receive().
+    bool query(const std::string& request, std::string* response);
+
+    const std::string& error() const { return error_; }
+
+private:
+    BlockClient(const BlockClient&);
+    BlockClient& operator=(const BlockClient&);
+
+    int fd_;
+    std::string buf_;   // received but not yet returned bytes
+    size_t pos_;
+    std::string error_;
+};
+
+#endif // CLIENT_H
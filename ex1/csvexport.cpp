@@ -0,0 +1,247 @@
+#include "csvexport.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <zlib.h>
+
+// Rows per chunk: a few MB of text, large enough that one write() and one
+// gzip member per chunk cost nothing, small enough to keep memory flat.
+static const size_t CHUNK_ROWS = 16384;
+// Chunks a worker may run ahead of the writer, per worker.
+static const size_t CHUNKS_AHEAD = 2;
+// Longest a row can get apart from relayed_by: two hashes, an ISO time,
+// four int64s, two int32s and the separators.
+static const size_t MAX_FIXED_ROW = 2 * 64 + ISO_TIME_MAX + 6 * 20 + 16;
+
+bool parse_csv_columns(std::string_view list, std::vector<BlockField>* columns) {
+    columns->clear();
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        while (!name.empty() && name.front() == ' ') name.remove_prefix(1);
+        while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+        if (name == "all") {
+            for (uint32_t f = FIELD_HASH; f <= FIELD_SIZE; f <<= 1) columns->push_back((BlockField)f);
+        } else if (uint32_t f = block_field(name)) {
+            columns->push_back((BlockField)f);
+        } else if (!name.empty()) {
+            return false;
+        }
+    }
+    return !columns->empty();
+}
+
+namespace {
+
+// relayed_by as it goes into the file, per dictionary id: quoted (with
+// doubled quotes) only if it holds a comma, quote or line break.
+std::vector<std::string> csv_dictionary(const StringDict& dict) {
+    std::vector<std::string> out(dict.size());
+    for (size_t id = 0; id < dict.size(); ++id) {
+        const std::string& s = dict.get((uint32_t)id);
+        if (s.find_first_of(",\"\r\n") == std::string::npos) {
+            out[id] = s;
+            continue;
+        }
+        out[id] = "\"";
+        for (char c : s) {
+            out[id] += c;
+            if (c == '"') out[id] += '"';
+        }
+        out[id] += '"';
+    }
+    return out;
+}
+
+struct ExportJob {
+    const BlockTable& table;
+    const CsvExportOptions& options;
+    std::vector<std::string> relayed;
+    std::string header;
+};
+
+template <typename T>
+char* put_number(char* p, T value) {
+    return std::to_chars(p, p + 20, value).ptr;
+}
+
+// Formats rows [first, last) that are in the height range onto `out`.
+size_t format_rows(const ExportJob& job, size_t first, size_t last, std::string& out) {
+    const BlockTable& t = job.table;
+    const std::vector<BlockField>& columns = job.options.columns;
+    size_t rows = 0;
+    size_t used = out.size();
+    out.resize(used + (last - first) * (MAX_FIXED_ROW / 2));  // a typical row is well under this
+    for (size_t i = first; i < last; ++i) {
+        int height = t.height(i);
+        if (height < job.options.from_height || height > job.options.to_height) continue;
+        const std::string& relayed = job.relayed[t.relayed_ids()[i]];
+        size_t need = MAX_FIXED_ROW + relayed.size();
+        if (out.size() - used < need) out.resize(std::max(out.size() * 2, used + need));
+        char* p = &out[used];
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (c > 0) *p++ = ',';
+            switch (columns[c]) {
+                case FIELD_HASH: to_hex(t.hash(i).bytes, 32, p); p += 64; break;
+                case FIELD_HEIGHT: p = put_number(p, height); break;
+                case FIELD_TOTAL: p = put_number(p, t.total(i)); break;
+                case FIELD_TIME: p += format_iso_time(t.time(i), p); break;
+                case FIELD_RELAYED_BY: memcpy(p, relayed.data(), relayed.size()); p += relayed.size(); break;
+                case FIELD_PREV_BLOCK: to_hex(t.prev_block(i).bytes, 32, p); p += 64; break;
+                case FIELD_N_TX: p = put_number(p, t.n_tx(i)); break;
+                case FIELD_FEES: p = put_number(p, t.fee(i)); break;
+                case FIELD_SIZE: p = put_number(p, t.size_bytes(i)); break;
+            }
+        }
+        *p++ = '\n';
+        used = p - &out[0];
+        ++rows;
+    }
+    out.resize(used);
+    return rows;
+}
+
+// Compresses `text` as one complete gzip member.
+bool gzip_member(const std::string& text, int level, std::string& out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    out.resize(deflateBound(&zs, text.size()));
+    zs.next_in = (Bytef*)text.data();
+    zs.avail_in = (uInt)text.size();
+    zs.next_out = (Bytef*)&out[0];
+    zs.avail_out = (uInt)out.size();
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
+
+struct Chunk {
+    std::string data;
+    size_t rows = 0;
+    size_t text_bytes = 0;
+    bool ready = false;
+    bool ok = true;
+};
+
+} // namespace
+
+bool write_csv(const BlockTable& table, const CsvExportOptions& options, CsvExportStats* stats) {
+    auto t0 = std::chrono::steady_clock::now();
+    if (options.columns.empty() || options.gzip_level < 0 || options.gzip_level > 9) {
+        std::cerr << "Invalid CSV export options" << std::endl;
+        return false;
+    }
+    std::ofstream output(options.path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        std::cerr << "Failed to create " << options.path << std::endl;
+        return false;
+    }
+
+    ExportJob job{table, options, csv_dictionary(table.relayed_dict()), std::string()};
+    for (size_t c = 0; c < options.columns.size(); ++c) {
+        job.header += c > 0 ? "," : "";
+        job.header += block_field_name(options.columns[c]);
+    }
+    job.header += '\n';
+
+    // The header is part of chunk 0, so even an empty export has one.
+    size_t n = table.size();
+    size_t chunk_count = std::max<size_t>(1, (n + CHUNK_ROWS - 1) / CHUNK_ROWS);
+    size_t workers = options.threads > 0 ? (size_t)options.threads
+                                         : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, chunk_count);
+
+    std::vector<Chunk> chunks(chunk_count);
+    std::mutex mutex;
+    std::condition_variable ready_cv, room_cv;
+    size_t claimed = 0, written = 0;
+    bool stop = false;
+    // Text buffers done with, reused so that formatting a chunk doesn't fault
+    // in fresh pages every time: one per chunk (the worker's when gzipping,
+    // else the writer's), never more than can be in flight.
+    std::vector<std::string> spare;
+    const size_t spare_max = CHUNKS_AHEAD * workers;
+
+    auto work = [&]() {
+        for (;;) {
+            size_t k;
+            std::string text;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                room_cv.wait(lock, [&] { return stop || claimed < written + CHUNKS_AHEAD * workers; });
+                if (stop || claimed == chunk_count) return;
+                k = claimed++;
+                if (!spare.empty()) {
+                    text.swap(spare.back());
+                    spare.pop_back();
+                }
+            }
+            Chunk done;
+            text.assign(k == 0 ? job.header : std::string());
+            done.rows = format_rows(job, k * CHUNK_ROWS, std::min(n, (k + 1) * CHUNK_ROWS), text);
+            done.text_bytes = text.size();
+            if (options.gzip_level > 0) done.ok = gzip_member(text, options.gzip_level, done.data);
+            else done.data.swap(text);
+            done.ready = true;
+            std::lock_guard<std::mutex> lock(mutex);
+            chunks[k] = std::move(done);
+            if (!text.empty() && spare.size() < spare_max) spare.push_back(std::move(text));
+            ready_cv.notify_all();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back(work);
+    }
+
+    CsvExportStats totals;
+    const char* error = nullptr;
+    for (size_t k = 0; k < chunk_count && !error; ++k) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready_cv.wait(lock, [&] { return chunks[k].ready; });
+            chunk = std::move(chunks[k]);
+            written = k + 1;
+            room_cv.notify_all();
+        }
+        if (!chunk.ok) {
+            error = "Failed to compress ";
+            break;
+        }
+        output.write(chunk.data.data(), chunk.data.size());
+        if (!output) error = "Failed to write ";
+        totals.rows += chunk.rows;
+        totals.text_bytes += chunk.text_bytes;
+        totals.file_bytes += chunk.data.size();
+        if (options.gzip_level > 0) continue;  // the worker kept its text buffer
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.size() < spare_max) spare.push_back(std::move(chunk.data));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        room_cv.notify_all();
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    output.close();
+    if (!error && !output) error = "Failed to write ";
+    if (error) {
+        std::cerr << error << options.path << std::endl;
+        return false;
+    }
+    totals.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (stats) *stats = totals;
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef CSVEXPORT_H
+#define CSVEXPORT_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chain.h"
+#include "json.h"
+
+// CSV export of the chain (ex3.out, export_to_csv()).
+//
+// Rows are cut into chunks that worker threads format into buffers of their
+// own: numbers through std::to_chars, hashes and times written in place, no
+// allocation per field. The calling thread writes finished chunks in order,
+// so the file never depends on scheduling, and workers stop a few chunks
+// ahead of the writer, so memory stays bounded whatever the chain size.
+//
+// With gzip every worker also compresses its chunk, as a gzip member of its
+// own; concatenated members are one valid .gz file (gunzip, zcat and
+// Python's gzip read them as a single stream), so compression runs in
+// parallel too.
+
+struct CsvExportOptions {
+    std::string path = "infoutput.csv";
+    // Columns in output order; the header uses the same names.
+    std::vector<BlockField> columns = {FIELD_HASH, FIELD_HEIGHT, FIELD_TOTAL,
+                                       FIELD_TIME, FIELD_RELAYED_BY, FIELD_PREV_BLOCK};
+    // Only blocks with from_height <= height <= to_height, in chain order.
+    int from_height = INT_MIN;
+    int to_height = INT_MAX;
+    int gzip_level = 0;  // 0: plain text, 1 (fastest) - 9 (smallest): gzip
+    int threads = 0;     // 0: one per core
+};
+
+struct CsvExportStats {
+    size_t rows = 0;
+    uint64_t text_bytes = 0;  // CSV before compression
+    uint64_t file_bytes = 0;  // written to the file
+    double milliseconds = 0;
+};
+
+// Parses a comma separated list of column names ("height,total,time"),
+// the names json.h uses, or "all". Returns false on an unknown name or an
+// empty list.
+bool parse_csv_columns(std::string_view list, std::vector<BlockField>* columns);
+
+// Writes the selected rows of `table` to options.path. Errors go to stderr.
+bool write_csv(const BlockTable& table, const CsvExportOptions& options, CsvExportStats* stats = nullptr);
+
+#endif // CSVEXPORT_H
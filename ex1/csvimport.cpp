@@ -0,0 +1,334 @@
+#include "csvimport.h"
+#include "json.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Below this many bytes per thread, another thread doesn't pay off.
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+// More fields than any header can name; extra ones are only counted.
+static const size_t MAX_FIELDS = 16;
+
+namespace {
+
+// Bit i set if an odd number of bits at or below i are set in x.
+inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Yields the commas and newlines of [begin, end) that are outside quoted
+// fields, in order. Each 64-byte window is classified with SSE2 compares;
+// the quote state is carried from one window to the next.
+class DelimiterScanner {
+public:
+    DelimiterScanner(const char* begin, const char* end) : window_(begin), end_(end), bits_(0), quoted_(0) {
+        load();
+    }
+
+    bool next(const char** pos) {
+        while (bits_ == 0) {
+            window_ += 64;
+            if (window_ >= end_) return false;
+            load();
+        }
+        *pos = window_ + __builtin_ctzll(bits_);
+        bits_ &= bits_ - 1;
+        return true;
+    }
+
+private:
+    void load() {
+        const char* p = window_;
+        char last[64];
+        if (end_ - window_ < 64) {
+            memset(last, ' ', sizeof(last));
+            memcpy(last, window_, end_ - window_);
+            p = last;
+        }
+        uint64_t quote = 0, delim = 0;
+#ifdef __SSE2__
+        const __m128i q = _mm_set1_epi8('"');
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+            quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (16 * k);
+            __m128i d = _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline));
+            delim |= (uint64_t)(uint16_t)_mm_movemask_epi8(d) << (16 * k);
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            if (p[i] == '"') quote |= 1ull << i;
+            else if (p[i] == ',' || p[i] == '\n') delim |= 1ull << i;
+        }
+#endif
+        uint64_t inside = prefix_xor(quote) ^ quoted_;
+        quoted_ = (uint64_t)((int64_t)inside >> 63);
+        bits_ = delim & ~inside;
+    }
+
+    const char* window_;
+    const char* end_;
+    uint64_t bits_;
+    uint64_t quoted_;  // all ones if the window ended inside quotes
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+template <typename T>
+bool parse_number(std::string_view s, T* out) {
+    const char* end = s.data() + s.size();
+    std::from_chars_result r = std::from_chars(s.data(), end, *out);
+    return r.ec == std::errc() && r.ptr == end;
+}
+
+// Rows of one chunk, parsed on one thread into a table of its own.
+class ChunkParser {
+public:
+    ChunkParser(const std::vector<BlockField>& columns, BlockTable& out, ParseReport* report)
+        : columns_(columns), out_(out), report_(report), lines_(0) {}
+
+    void run(const char* begin, const char* end) {
+        out_.reserve((end - begin) / 150 + 1);
+        std::string_view fields[MAX_FIELDS];
+        size_t count = 0;
+        const char* start = begin;
+        const char* pos;
+        DelimiterScanner scanner(begin, end);
+        while (scanner.next(&pos)) {
+            if (count < MAX_FIELDS) fields[count] = std::string_view(start, pos - start);
+            ++count;
+            start = pos + 1;
+            if (*pos == '\n') {
+                row(fields, count);
+                count = 0;
+            }
+        }
+        if (start < end || count > 0) {
+            if (count < MAX_FIELDS) fields[count] = std::string_view(start, end - start);
+            row(fields, count + 1);
+        }
+    }
+
+    size_t lines() const { return lines_; }
+
+private:
+    void row(std::string_view* fields, size_t count) {
+        ++lines_;
+        if (count == 1 && trim(fields[0]).empty()) return;
+        if (count != columns_.size()) {
+            fail("expected " + std::to_string(columns_.size()) + " fields, got " + std::to_string(count));
+            return;
+        }
+        Hash32 hash, prev_block;
+        memset(prev_block.bytes, 0, sizeof(prev_block.bytes));
+        int height = -1, n_tx = -1, size = -1;
+        int64_t total = -1, time = 0, fees = -1;
+        std::string_view relayed_by;
+        std::string unquoted;
+        for (size_t c = 0; c < count; ++c) {
+            std::string_view v = fields[c];
+            if (!v.empty() && v.back() == '\r') v.remove_suffix(1);
+            bool ok = true;
+            switch (columns_[c]) {
+                case FIELD_HASH: ok = from_hex(v, hash.bytes, 32); break;
+                case FIELD_HEIGHT: ok = parse_number(v, &height); break;
+                case FIELD_TOTAL: ok = parse_number(v, &total); break;
+                case FIELD_TIME: ok = parse_iso_time(v, &time); break;
+                case FIELD_RELAYED_BY:
+                    relayed_by = v;
+                    if (v.size() >= 2 && v.front() == '"' && v.back() == '"') {
+                        for (size_t i = 1; i + 1 < v.size(); ++i) {
+                            unquoted += v[i];
+                            if (v[i] == '"') ++i;  // "" stands for one quote
+                        }
+                        relayed_by = unquoted;
+                    }
+                    break;
+                case FIELD_PREV_BLOCK: ok = from_hex(v, prev_block.bytes, 32); break;
+                case FIELD_N_TX: ok = parse_number(v, &n_tx); break;
+                case FIELD_FEES: ok = parse_number(v, &fees); break;
+                case FIELD_SIZE: ok = parse_number(v, &size); break;
+            }
+            if (!ok) {
+                fail(std::string("malformed ") + block_field_name(columns_[c]));
+                return;
+            }
+        }
+        out_.append(hash, height, total, time, relayed_by, prev_block, n_tx, fees, size);
+        ++report_->blocks;
+    }
+
+    void fail(const std::string& message) {
+        ++report_->skipped;
+        if (report_->issues.size() < ParseReport::MAX_PARSE_ISSUES) {
+            report_->issues.push_back(ParseIssue{lines_, message});  // relative to the chunk for now
+        }
+    }
+
+    const std::vector<BlockField>& columns_;
+    BlockTable& out_;
+    ParseReport* report_;
+    size_t lines_;
+};
+
+// Parses the header line; on failure `*error` says why.
+bool parse_header(std::string_view line, std::vector<BlockField>* columns, std::string* error) {
+    uint32_t seen = 0;
+    while (true) {
+        size_t comma = line.find(',');
+        std::string_view name = trim(line.substr(0, comma));
+        uint32_t field = block_field(name);
+        if (!field) {
+            *error = "unknown column '" + std::string(name) + "'";
+            return false;
+        }
+        if (seen & field) {
+            *error = "column '" + std::string(name) + "' appears twice";
+            return false;
+        }
+        seen |= field;
+        columns->push_back((BlockField)field);
+        if (comma == std::string_view::npos) break;
+        line.remove_prefix(comma + 1);
+    }
+    if (!(seen & FIELD_HASH)) {
+        *error = "no hash column";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parse_csv_text(std::string_view text, BlockTable& out, ParseReport* report, int threads) {
+    ParseReport local;
+    if (!report) report = &local;
+    size_t header_end = text.find('\n');
+    std::string_view header = text.substr(0, header_end);
+    std::vector<BlockField> columns;
+    std::string error;
+    if (trim(header).empty()) error = "missing header";
+    if (!error.empty() || !parse_header(header, &columns, &error)) {
+        report->issues.push_back(ParseIssue{1, error});
+        return false;
+    }
+    if (header_end == std::string_view::npos) return true;
+
+    // Cut the body into line-aligned chunks, one per thread.
+    const char* body = text.data() + header_end + 1;
+    const char* end = text.data() + text.size();
+    size_t workers = threads > 0 ? (size_t)threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, std::max<size_t>(1, (end - body) / MIN_CHUNK_BYTES));
+    if (memchr(body, '"', end - body)) workers = 1;
+    std::vector<const char*> cuts(1, body);
+    for (size_t w = 1; w < workers; ++w) {
+        const char* cut = body + (end - body) * w / workers;
+        if (cut < cuts.back()) cut = cuts.back();
+        const char* nl = static_cast<const char*>(memchr(cut, '\n', end - cut));
+        cuts.push_back(nl ? nl + 1 : end);
+    }
+    cuts.push_back(end);
+    size_t chunks = cuts.size() - 1;
+
+    std::vector<BlockTable> tables(chunks);
+    std::vector<ParseReport> reports(chunks);
+    std::vector<size_t> lines(chunks);
+    auto parse = [&](size_t k) {
+        ChunkParser parser(columns, tables[k], &reports[k]);
+        parser.run(cuts[k], cuts[k + 1]);
+        lines[k] = parser.lines();
+    };
+    std::vector<std::thread> pool;
+    for (size_t k = 1; k < chunks; ++k) {
+        pool.emplace_back(parse, k);
+    }
+    parse(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    // Chunk k starts after the header and the lines of chunks 0 .. k-1.
+    size_t first_line = 2;
+    size_t rows = 0;
+    for (const BlockTable& t : tables) rows += t.size();
+    out.reserve(out.size() + rows);
+    for (size_t k = 0; k < chunks; ++k) {
+        out.append(tables[k]);
+        tables[k].clear();
+        report->blocks += reports[k].blocks;
+        report->skipped += reports[k].skipped;
+        for (const ParseIssue& issue : reports[k].issues) {
+            if (report->issues.size() >= ParseReport::MAX_PARSE_ISSUES) break;
+            report->issues.push_back(ParseIssue{first_line + issue.line - 1, issue.message});
+        }
+        first_line += lines[k];
+    }
+    return true;
+}
+
+bool parse_csv_file(const std::string& path, BlockTable& out, ParseReport* report, int threads) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    const char* text = "";
+    void* map = MAP_FAILED;
+    if (st.st_size > 0) {
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            std::cerr << "Failed to mmap " << path << std::endl;
+            return false;
+        }
+        text = static_cast<const char*>(map);
+    }
+    close(fd);
+
+    ParseReport local;
+    if (!report) report = &local;
+    bool ok;
+    if (st.st_size >= 2 && (uint8_t)text[0] == 0x1f && (uint8_t)text[1] == 0x8b) {
+        std::cerr << path << ": gzip compressed; decompress it first (gunzip)" << std::endl;
+        ok = false;
+    } else {
+        ok = parse_csv_text(std::string_view(text, st.st_size), out, report, threads);
+        if (!ok) std::cerr << path << ": " << report->issues.back().message << std::endl;
+    }
+    if (map != MAP_FAILED) munmap(map, st.st_size);
+    return ok;
+}
+
+bool looks_like_csv(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line)) return false;
+    std::string_view first = trim(std::string_view(line).substr(0, line.find(',')));
+    return block_field(first) != 0;
+}
@@ -0,0 +1,39 @@
+#ifndef CSVIMPORT_H
+#define CSVIMPORT_H
+
+#include <string>
+#include <string_view>
+#include "chain.h"
+#include "parser.h"
+
+// Reads CSV written by export_to_csv() / write_csv() (csvexport.h) back
+// into a BlockTable, so an exported chain can be loaded or converted to
+// info.db / info.seg again.
+//
+// The header names the columns, in any order and any subset of the names
+// json.h uses; the hash is required and missing columns keep their unknown
+// value (-1, or 0 for the time and an all-zero prev_block), as with
+// --fields. Rows are read in file order.
+//
+// The file is mapped and cut into line-aligned chunks parsed on separate
+// threads into tables of their own, which are then appended in order.
+// Delimiters are found 64 bytes at a time with SSE2 compares (commas and
+// newlines outside quotes, like the structural scan in json.cpp), so the
+// bytes inside a field are never looked at one by one except to decode
+// them. A file with quoted fields is parsed on one thread, since a quoted
+// newline could sit where a chunk would be cut. Malformed rows are skipped
+// and reported with their line number.
+
+// Parses `text` (header included) and appends the rows to `out`.
+// `threads` 0 means one per core. Returns false (and appends nothing) if
+// the header is missing, lacks the hash or names an unknown column.
+bool parse_csv_text(std::string_view text, BlockTable& out, ParseReport* report, int threads = 0);
+
+// Maps `path` and parses it. Returns false if the file can't be opened or
+// parse_csv_text() fails; the reason goes to stderr.
+bool parse_csv_file(const std::string& path, BlockTable& out, ParseReport* report, int threads = 0);
+
+// True if the first line of `path` is a header naming block fields.
+bool looks_like_csv(const std::string& path);
+
+#endif // CSVIMPORT_H
@@ -1,12 +1,90 @@
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdio>
 #include "infra.h"
+#include "batch.h"
+
+// Queries resolved per window; bounds memory for very large inputs.
+static const size_t BATCH_WINDOW = 65536;
+
+static void usage(const char* program) {
+    std::cout << "Usage:\n"
+              << "  " << program << " --height <height>\n"
+              << "  " << program << " --hash <hash or prefix>\n"
+              << "  " << program << " --batch <file|-> [--format text|json] [--threads <n>]\n";
+}
+
+// Reads one query per line (a height or a hash) from a file or stdin and
+// writes the results in input order; the summary goes to stderr.
+static int run_batch(int argc, char* argv[]) {
+    std::string input = argv[2];
+    BatchFormat format = BATCH_TEXT;
+    int threads = (int)std::thread::hardware_concurrency();
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string opt = argv[i], value = argv[i + 1];
+        if (opt == "--format" && (value == "text" || value == "json")) {
+            format = value == "json" ? BATCH_JSON : BATCH_TEXT;
+        } else if (opt == "--threads") {
+            threads = std::max(1, atoi(value.c_str()));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc % 2 == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file;
+    if (input != "-") {
+        file.open(input);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << input << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = input == "-" ? std::cin : file;
+    // Output goes through fwrite; only stdin needs to be fast through iostreams.
+    std::ios::sync_with_stdio(false);
+
+    load_db();
+    auto t0 = std::chrono::steady_clock::now();
+    BatchStats stats;
+    std::vector<std::string> lines;
+    std::vector<std::string_view> queries;
+    std::string out;
+    std::string line;
+    bool more = true;
+    while (more) {
+        lines.clear();
+        while (lines.size() < BATCH_WINDOW && (more = (bool)std::getline(in, line))) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos) lines.push_back(line);
+        }
+        queries.assign(lines.begin(), lines.end());
+        out.clear();
+        resolve_batch(queries, format, threads, &out, &stats);
+        fwrite(out.data(), 1, out.size(), stdout);
+    }
+    fflush(stdout);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cerr << "Resolved " << stats.queries << " queries (" << stats.found << " found, " << stats.invalid
+              << " invalid) in " << seconds * 1e3 << " ms with " << threads << " thread(s): "
+              << (size_t)(stats.queries / (seconds > 0 ? seconds : 1e-9)) << " queries/s" << std::endl;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--batch") {
+        return run_batch(argc, argv);
+    }
     if (argc != 3) {
-        std::cout << "Usage:\n"
-                  << "  " << argv[0] << " --height <height>\n"
-                  << "  " << argv[0] << " --hash <hash>\n";
+        usage(argv[0]);
         return 1;
     }
 
@@ -23,12 +101,15 @@ int main(int argc, char* argv[]) {
         }
     } else if (option == "--hash") {
         std::string hash = argv[2];
-        find_block_by_hash(hash.c_str());
+        // Anything shorter than a full hash is a prefix pasted from an explorer.
+        if (hash.size() == 64) {
+            find_block_by_hash(hash.c_str());
+        } else {
+            find_block_by_hash_prefix(hash.c_str());
+        }
     } else {
         std::cout << "Unknown option: " << option << "\n";
-        std::cout << "Usage:\n"
-                  << "  " << argv[0] << " --height <height>\n"
-                  << "  " << argv[0] << " --hash <hash>\n";
+        usage(argv[0]);
         return 1;
     }
 
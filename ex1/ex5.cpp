@@ -27,9 +27,13 @@ int main() {
                 print_db();
                 break;
             case 2:
-                std::cout << "Enter block hash: ";
+                std::cout << "Enter block hash (or its first digits): ";
                 std::getline(std::cin, input_hash);
-                find_block_by_hash(input_hash.c_str());
+                if (input_hash.size() == 64) {
+                    find_block_by_hash(input_hash.c_str());
+                } else {
+                    find_block_by_hash_prefix(input_hash.c_str());
+                }
                 break;
             case 3:
                 std::cout << "Enter block height: ";
@@ -41,11 +45,16 @@ int main() {
                 export_to_csv();
                 break;
             case 5:
-                refresh_data();
-                // After refreshing, reload the blockchain data
-                load_db();
+                // Runs in the background; the other options keep answering
+                // from the current chain until the refreshed one replaces it.
+                if (refresh_data_async()) {
+                    std::cout << "Refreshing in the background..." << std::endl;
+                } else {
+                    std::cout << "A refresh is already running." << std::endl;
+                }
                 break;
             case 0:
+                wait_for_refresh();
                 std::cout << "Goodbye!" << std::endl;
                 return 0;
             default:
@@ -0,0 +1,99 @@
+#include "fetcher.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Backoff before retry n is RETRY_BASE_MS * 2^n, capped at RETRY_MAX_MS.
+static const int RETRY_BASE_MS = 200;
+static const int RETRY_MAX_MS = 5000;
+
+static bool retryable(int status) {
+    return status == 429 || status >= 500;
+}
+
+static int backoff_ms(int attempt, size_t id) {
+    int delay = RETRY_BASE_MS << (attempt < 5 ? attempt : 5);
+    if (delay > RETRY_MAX_MS) delay = RETRY_MAX_MS;
+    // Spread retries of different ids so they don't hit the server together.
+    return delay + (int)(id % 8) * delay / 16;
+}
+
+bool get_with_retry(HttpConnection& conn, const Url& base, const std::string& path,
+                    const RefreshOptions& options, size_t id, std::string* body,
+                    std::string* problem, FetchStats* stats) {
+    for (int attempt = 0;; ++attempt) {
+        int status = 0;
+        ++stats->requests;
+        bool sent = conn.get(base, path, &status, body);
+        if (sent && status == 200) {
+            return true;
+        }
+        *problem = sent ? "HTTP " + std::to_string(status) : conn.error();
+        if ((sent && !retryable(status)) || attempt >= options.max_retries) {
+            return false;
+        }
+        ++stats->retries;
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms(attempt, id)));
+    }
+}
+
+bool fetch_blocks(const RefreshOptions& options, const std::vector<std::string>& ids,
+                  std::vector<Block>* out, std::vector<bool>* ok, FetchStats* stats) {
+    out->assign(ids.size(), Block());
+    ok->assign(ids.size(), false);
+    Url base;
+    if (!parse_url(options.base_url, &base)) {
+        std::cerr << "Refresh: bad API URL " << options.base_url << std::endl;
+        stats->failed = ids.size();
+        return false;
+    }
+
+    std::vector<char> done(ids.size(), 0);  // vector<bool> can't be written from several threads
+    std::atomic<size_t> next(0), requests(0), retries(0);
+    std::mutex log_mutex;
+
+    auto worker = [&]() {
+        HttpConnection conn;  // Kept alive across all the ids this worker takes
+        std::string body;
+        for (size_t i; (i = next++) < ids.size();) {
+            std::string path = api_path(base, options, "/blocks/" + ids[i]);
+            std::string problem;
+            FetchStats own;
+            if (get_with_retry(conn, base, path, options, i, &body, &problem, &own)) {
+                if (block_from_json(body, &(*out)[i])) {
+                    done[i] = 1;
+                } else {
+                    problem = "unexpected block document";
+                }
+            }
+            requests += own.requests;
+            retries += own.retries;
+            if (!done[i]) {
+                std::lock_guard<std::mutex> lock(log_mutex);
+                std::cerr << "Refresh: block " << ids[i] << ": " << problem << std::endl;
+            }
+        }
+    };
+
+    size_t workers = options.connections < 1 ? 1 : (size_t)options.connections;
+    if (workers > ids.size()) workers = ids.size();
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    if (workers > 0) worker();  // The calling thread is one of the workers
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    stats->requests = requests;
+    stats->retries = retries;
+    stats->failed = 0;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        (*ok)[i] = done[i] != 0;
+        if (!done[i]) ++stats->failed;
+    }
+    return stats->failed == 0;
+}
@@ -0,0 +1,36 @@
+#ifndef FETCHER_H
+#define FETCHER_H
+
+#include <string>
+#include <vector>
+#include "chain.h"
+#include "http.h"
+#include "refresh.h"
+
+// Concurrent block fetcher used by the incremental refresh.
+//
+// A fixed pool of worker threads each owns one keep-alive connection, so
+// at most `connections` requests are in flight at any time. Failed requests
+// (network errors, HTTP 429 and 5xx) are retried with exponential backoff.
+// Responses are parsed straight into Block records.
+
+struct FetchStats {
+    size_t requests = 0;   // HTTP requests sent, including retries
+    size_t retries = 0;
+    size_t failed = 0;     // ids that could not be fetched
+};
+
+// GETs `path` on `conn` until it returns 200, retrying network errors, 429
+// and 5xx up to options.max_retries times with backoff. On failure `problem`
+// describes the last error. `id` only staggers the backoff between callers.
+bool get_with_retry(HttpConnection& conn, const Url& base, const std::string& path,
+                    const RefreshOptions& options, size_t id, std::string* body,
+                    std::string* problem, FetchStats* stats);
+
+// Fetches `<base>/blocks/<id>` for every id (a block hash or a height).
+// out[i] corresponds to ids[i]; ok[i] is false if that id failed.
+// Returns true if every id was fetched.
+bool fetch_blocks(const RefreshOptions& options, const std::vector<std::string>& ids,
+                  std::vector<Block>* out, std::vector<bool>* ok, FetchStats* stats);
+
+#endif // FETCHER_H
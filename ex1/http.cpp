@@ -0,0 +1,253 @@
+#include "http.h"
+#include <cstring>
+#include <cstdlib>
+#include <strings.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+
+static const int HTTP_TIMEOUT_SEC = 15;
+
+bool parse_url(const std::string& text, Url* out) {
+    std::string rest;
+    if (text.compare(0, 7, "http://") == 0) {
+        out->tls = false;
+        out->port = 80;
+        rest = text.substr(7);
+    } else if (text.compare(0, 8, "https://") == 0) {
+        out->tls = true;
+        out->port = 443;
+        rest = text.substr(8);
+    } else {
+        return false;
+    }
+
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    out->path = slash == std::string::npos ? "/" : rest.substr(slash);
+    size_t colon = authority.find(':');
+    if (colon != std::string::npos) {
+        out->port = atoi(authority.c_str() + colon + 1);
+        authority.resize(colon);
+    }
+    out->host = authority;
+    return !out->host.empty() && out->port > 0;
+}
+
+// Created once on first use; static initialisation makes this safe when
+// several fetcher threads connect at the same time.
+static SSL_CTX* shared_ssl_ctx() {
+    static SSL_CTX* ctx = [] {
+        SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+        if (c) {
+            SSL_CTX_set_default_verify_paths(c);
+            SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
+        }
+        return c;
+    }();
+    return ctx;
+}
+
+HttpConnection::HttpConnection() : fd_(-1), ssl_(nullptr), port_(0), tls_(false), pos_(0) {}
+
+HttpConnection::~HttpConnection() {
+    close();
+}
+
+void HttpConnection::close() {
+    if (ssl_) {
+        SSL_free(static_cast<SSL*>(ssl_));
+        ssl_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buf_.clear();
+    pos_ = 0;
+}
+
+bool HttpConnection::connect(const Url& url) {
+    close();
+    struct addrinfo hints, *res = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    std::string port = std::to_string(url.port);
+    if (getaddrinfo(url.host.c_str(), port.c_str(), &hints, &res) != 0) {
+        error_ = "cannot resolve " + url.host;
+        return false;
+    }
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd_ < 0) continue;
+        if (::connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        ::close(fd_);
+        fd_ = -1;
+    }
+    freeaddrinfo(res);
+    if (fd_ < 0) {
+        error_ = "cannot connect to " + url.host + ":" + port;
+        return false;
+    }
+
+    struct timeval tv = {HTTP_TIMEOUT_SEC, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (url.tls) {
+        SSL_CTX* ctx = shared_ssl_ctx();
+        SSL* ssl = ctx ? SSL_new(ctx) : nullptr;
+        if (!ssl) {
+            error_ = "TLS setup failed";
+            close();
+            return false;
+        }
+        ssl_ = ssl;
+        SSL_set_fd(ssl, fd_);
+        SSL_set_tlsext_host_name(ssl, url.host.c_str());
+        SSL_set1_host(ssl, url.host.c_str());
+        if (SSL_connect(ssl) != 1) {
+            error_ = "TLS handshake with " + url.host + " failed";
+            close();
+            return false;
+        }
+    }
+
+    host_ = url.host;
+    port_ = url.port;
+    tls_ = url.tls;
+    return true;
+}
+
+bool HttpConnection::send_all(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = ssl_ ? SSL_write(static_cast<SSL*>(ssl_), data.data() + sent, (int)(data.size() - sent))
+                     : (int)::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool HttpConnection::fill() {
+    if (pos_ > 0) {
+        buf_.erase(0, pos_);
+        pos_ = 0;
+    }
+    char tmp[16384];
+    int n = ssl_ ? SSL_read(static_cast<SSL*>(ssl_), tmp, sizeof(tmp))
+                 : (int)::recv(fd_, tmp, sizeof(tmp), 0);
+    if (n <= 0) return false;
+    buf_.append(tmp, n);
+    return true;
+}
+
+bool HttpConnection::read_line(std::string* line) {
+    for (;;) {
+        size_t nl = buf_.find('\n', pos_);
+        if (nl != std::string::npos) {
+            size_t end = (nl > pos_ && buf_[nl - 1] == '\r') ? nl - 1 : nl;
+            line->assign(buf_, pos_, end - pos_);
+            pos_ = nl + 1;
+            return true;
+        }
+        if (!fill()) return false;
+    }
+}
+
+bool HttpConnection::read_exact(size_t n, std::string* out) {
+    while (buf_.size() - pos_ < n) {
+        if (!fill()) return false;
+    }
+    out->append(buf_, pos_, n);
+    pos_ += n;
+    return true;
+}
+
+bool HttpConnection::read_response(int* status, std::string* body, bool* keep_alive) {
+    std::string line;
+    if (!read_line(&line) || line.compare(0, 5, "HTTP/") != 0) {
+        return false;
+    }
+    size_t sp = line.find(' ');
+    *status = sp == std::string::npos ? 0 : atoi(line.c_str() + sp + 1);
+    *keep_alive = line.compare(0, 8, "HTTP/1.1") == 0;
+
+    long long content_length = -1;
+    bool chunked = false;
+    while (read_line(&line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = line.substr(0, colon);
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+            content_length = atoll(value.c_str());
+        } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+            chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+        } else if (strcasecmp(name.c_str(), "Connection") == 0) {
+            if (strcasestr(value.c_str(), "close")) *keep_alive = false;
+            if (strcasestr(value.c_str(), "keep-alive")) *keep_alive = true;
+        }
+    }
+
+    body->clear();
+    if (chunked) {
+        for (;;) {
+            if (!read_line(&line)) return false;
+            size_t size = strtoul(line.c_str(), nullptr, 16);
+            if (size == 0) {
+                while (read_line(&line) && !line.empty()) {}  // Trailers
+                return true;
+            }
+            std::string crlf;
+            if (!read_exact(size, body) || !read_line(&crlf)) return false;
+        }
+    }
+    if (content_length >= 0) {
+        return read_exact((size_t)content_length, body);
+    }
+    // No length: body runs until the server closes the connection.
+    *keep_alive = false;
+    body->append(buf_, pos_, std::string::npos);
+    pos_ = buf_.size();
+    while (fill()) {
+        body->append(buf_, pos_, std::string::npos);
+        pos_ = buf_.size();
+    }
+    return true;
+}
+
+bool HttpConnection::get(const Url& base, const std::string& path, int* status, std::string* body) {
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + base.host + "\r\n"
+                          "User-Agent: libinfra\r\n"
+                          "Accept: application/json\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+
+    // A kept-alive connection may have been closed by the server in the
+    // meantime; in that case retry once on a fresh connection.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = fd_ >= 0 && host_ == base.host && port_ == base.port && tls_ == base.tls;
+        if (!reused && !connect(base)) {
+            return false;
+        }
+        bool keep_alive = false;
+        if (send_all(request) && read_response(status, body, &keep_alive)) {
+            if (!keep_alive) close();
+            return true;
+        }
+        close();
+        if (!reused) break;
+    }
+    error_ = "request to " + base.host + path + " failed";
+    return false;
+}
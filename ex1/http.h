@@ -0,0 +1,54 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <string>
+
+// Minimal HTTP/1.1 client used to talk to the BlockCypher API (or a local
+// stand-in server). Supports plain http:// and https:// (OpenSSL), GET only,
+// Content-Length and chunked bodies, and keeps the connection open between
+// requests when the server allows it.
+
+struct Url {
+    bool tls = false;
+    std::string host;
+    int port = 80;
+    std::string path;   // always starts with '/'
+};
+
+// Accepts "http://host[:port]/path" and "https://host[:port]/path".
+bool parse_url(const std::string& text, Url* out);
+
+class HttpConnection {
+public:
+    HttpConnection();
+    ~HttpConnection();
+
+    // Sends GET `path` to host:port, reconnecting if the previous connection
+    // was closed. Returns false on a network/protocol error (see error()).
+    bool get(const Url& base, const std::string& path, int* status, std::string* body);
+
+    void close();
+    const std::string& error() const { return error_; }
+
+private:
+    HttpConnection(const HttpConnection&);
+    HttpConnection& operator=(const HttpConnection&);
+
+    bool connect(const Url& url);
+    bool send_all(const std::string& data);
+    bool fill();  // Reads more bytes into buf_
+    bool read_line(std::string* line);
+    bool read_exact(size_t n, std::string* out);
+    bool read_response(int* status, std::string* body, bool* keep_alive);
+
+    int fd_;
+    void* ssl_;          // SSL*, kept opaque so users don't need OpenSSL headers
+    std::string host_;
+    int port_;
+    bool tls_;
+    std::string buf_;    // received but not yet consumed bytes
+    size_t pos_;
+    std::string error_;
+};
+
+#endif // HTTP_H
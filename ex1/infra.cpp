@@ -4,11 +4,44 @@
 #include <string>     
 #include <vector>
 #include <algorithm>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include "blockstore.h"
+#include "blockview.h"
+#include "csvexport.h"
+#include "csvimport.h"
+#include "blockindex.h"
+#include "parser.h"
+#include "refresh.h"
+#include "segstore.h"
+#include "snapshot.h"
 
-std::vector<Block> blockchain;
+// Blocks fetched by refresh_data() when nothing is loaded yet.
+#define INITIAL_REFRESH_BLOCKS 10
+// Candidates listed by find_block_by_hash_prefix() for an ambiguous prefix,
+// and gaps/forks listed by print_chain_report().
+#define LIST_LIMIT 10
 
+// Readers never lock anything (see snapshot.h); writers (load_db() and
+// refresh_data()) take this so that two of them don't build on the same
+// snapshot and lose each other's blocks.
+static std::mutex writer_mutex;
+static std::thread refresh_thread;
+static std::atomic<bool> refreshing(false);
+
+// Counts blocks in an info.txt file, or reads the count from the header
+// if `filename` is a binary block store.
 int countBlocks(const std::string& filename) {
+    uint64_t stored = 0;
+    if (read_store_count(filename, &stored)) {
+        return (int)stored;
+    }
+
     std::ifstream file(filename);
     std::string line;
     int count = 0;
@@ -47,133 +80,557 @@ std::string cleanLine(const std::string& line) {
     return value;
 }
 
-// Loads all blocks from info.txt into the global blockchain vector.
-// Assumes each block is represented by 6 or 7 lines (if 'received_time' exists).
-void load_db() {
-    // Open the info.txt file for reading
-    std::ifstream file("info.txt");
-    std::string line;
-    std::vector<std::string> blockLines;
-    blockchain.clear(); // Clear previous data
+// One line on stderr if parsing left anything out.
+static void warn_if_skipped(const std::string& path, const ParseReport& report, const char* what) {
+    if (report.skipped == 0) return;
+    std::cerr << path << ": skipped " << report.skipped << " malformed " << what;
+    if (!report.issues.empty()) {
+        std::cerr << ", first at line " << report.issues[0].line << ": " << report.issues[0].message;
+    }
+    std::cerr << std::endl;
+}
 
-    while (std::getline(file, line)) {
-        if (line.empty()) continue; // Skip empty lines
-        blockLines.push_back(line);
-
-        if (blockLines.size() == 6) {
-            Block b;
-            try {
-                b.hash = cleanLine(blockLines[0]);
-                b.height = std::stoi(cleanLine(blockLines[1]));
-                b.total = std::stoll(cleanLine(blockLines[2]));
-                b.time = cleanLine(blockLines[3]);
-                b.relayed_by = cleanLine(blockLines[4]);
-                b.prev_block = cleanLine(blockLines[5]);
-            } catch (...) {
-                // Skip block if there is a parsing error
-                blockLines.clear();
-                continue;
-            }
-            blockchain.push_back(b); // Add the block to the vector
-            blockLines.clear();
+// Parses all blocks from a text file in the info.txt format into `out`.
+// Malformed blocks are skipped; a short summary goes to stderr.
+bool load_txt(const std::string& path, BlockTable& out, size_t* skipped) {
+    out.clear();
+    ParseReport report;
+    if (!parse_info_file(path, out, &report)) {
+        return false;
+    }
+    if (skipped) *skipped = report.skipped;
+    warn_if_skipped(path, report, "block(s)");
+    return true;
+}
+
+
+// Returns true if info.db exists and is at least as new as info.txt,
+// i.e. the binary store can be served instead of re-parsing the text.
+// Compared to the nanosecond: info.txt rewritten in the same second the
+// store was saved must still count as newer.
+static bool store_is_current() {
+    struct stat db, txt;
+    if (stat(STORE_FILE, &db) != 0) return false;
+    if (stat("info.txt", &txt) != 0) return true;
+    if (db.st_mtim.tv_sec != txt.st_mtim.tv_sec) return db.st_mtim.tv_sec > txt.st_mtim.tv_sec;
+    return db.st_mtim.tv_nsec >= txt.st_mtim.tv_nsec;
+}
+
+// One line on stderr if the integrity check found anything; the details
+// are in print_validation_report(). Parse errors were already reported.
+static void warn_if_invalid(const char* source, const ValidationReport& r) {
+    if (r.gaps == 0 && r.broken_links == 0 && r.duplicate_hashes == 0 && r.duplicate_heights == 0) return;
+    std::cerr << source << ": chain check found " << r.gaps << " gap(s) (" << r.missing_heights
+              << " missing heights), " << r.broken_links << " broken link(s), " << r.duplicate_hashes
+              << " duplicate hash(es), " << r.duplicate_heights << " duplicate height(s)";
+    if (!r.issues.empty()) {
+        std::cerr << "; first: " << issue_name(r.issues[0].kind) << " at height " << r.issues[0].height;
+    }
+    std::cerr << std::endl;
+}
+
+// Loads the blockchain. Prefers the memory-mapped info.db (constant time,
+// columns are served from the mapping); falls back to parsing info.txt.
+// Either way the result is checked (see validate.h). The new chain is built
+// next to the current one and replaces it in one step, so queries running
+// meanwhile keep answering from the old one.
+void load_db() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    std::shared_ptr<ChainSnapshot> next;
+    const char* source = STORE_FILE;
+    if (store_is_current()) {
+        std::shared_ptr<BlockStore> store(new BlockStore());
+        BlockTable table;
+        if (store->open(STORE_FILE) && table.attach(store)) {
+            next.reset(new ChainSnapshot(std::move(table), true, 0));
         }
     }
-    file.close();
+    if (!next) {
+        BlockTable table;
+        size_t skipped = 0;
+        load_txt("info.txt", table, &skipped);
+        next.reset(new ChainSnapshot(std::move(table), false, skipped));
+        source = "info.txt";
+    }
+    warn_if_invalid(source, next->validation());
+    publish_snapshot(std::move(next));
+}
+
+// Builds the chain from an exported CSV (see csvimport.h) and publishes it
+// like load_db() does.
+bool load_csv(const std::string& path) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    BlockTable table;
+    ParseReport report;
+    if (!parse_csv_file(path, table, &report)) {
+        return false;
+    }
+    warn_if_skipped(path, report, "row(s)");
+    std::shared_ptr<ChainSnapshot> next(new ChainSnapshot(std::move(table), false, report.skipped));
+    warn_if_invalid(path.c_str(), next->validation());
+    publish_snapshot(std::move(next));
+    return true;
+}
+
+static void print_block(const BlockTable& chain, size_t i) {
+    BlockFormatter out;
+    out.block(BlockRef(chain, i));
 }
 
 // Prints all blocks in the blockchain in the required format (no quotes around values).
 // Prints an arrow between blocks for visual separation.
 void print_db() {
-    if (blockchain.empty()) {
+    BlockQuery query;
+    size_t count = query.size();
+    if (count == 0) {
         std::cout << "Blockchain is empty. Please run load_db() first." << std::endl;
         return;
     }
-    for (size_t i = 0; i < blockchain.size(); ++i) {
-        const auto& b = blockchain[i];
+    BlockFormatter out;
+    for (BlockRef b : query.all()) {
         // Print all block fields, one per line
-        std::cout << "hash: " << b.hash << std::endl;
-        std::cout << "height: " << b.height << std::endl;
-        std::cout << "total: " << b.total << std::endl;
-        std::cout << "time: " << b.time << std::endl;
-        std::cout << "relayed_by: " << b.relayed_by << std::endl;
-        std::cout << "prev_block: " << b.prev_block << std::endl;
+        out.block(b);
         // Print arrow only if not the last block
-        if (i != blockchain.size() - 1) {
-            std::cout << "    |\n    v\n" << std::endl;
+        if (b.row() != count - 1) {
+            out << "    |\n    v\n";
+            out.line();
         }
     }
 }
 
-// Finds and prints a block by its hash value.
-// Assumes blockchain is already loaded into memory.
+// Finds a block by its hash value via the hash index.
+bool lookup_hash(std::string_view hex, size_t* row) {
+    return chain_snapshot()->find_hash(hex, row);
+}
+
 void find_block_by_hash(const char* hash) {
-    for (const auto& b : blockchain) {
-        if (b.hash == hash) {
-            std::cout << "hash: " << b.hash << std::endl;
-            std::cout << "height: " << b.height << std::endl;
-            std::cout << "total: " << b.total << std::endl;
-            std::cout << "time: " << b.time << std::endl;
-            std::cout << "relayed_by: " << b.relayed_by << std::endl;
-            std::cout << "prev_block: " << b.prev_block << std::endl;
-            return;
-        }
+    BlockRef b;
+    if (BlockQuery().find_hash(hash, &b)) {
+        BlockFormatter out;
+        out.block(b);
+        return;
     }
     std::cout << "Block with hash '" << hash << "' not found." << std::endl;
 }
 
-// Finds and prints a block by its height value.
-// Assumes blockchain is already loaded into memory.
+static bool prefix_rows(const ChainSnapshot& snap, std::string_view prefix, size_t limit, std::vector<size_t>* rows,
+                        size_t* matches) {
+    rows->clear();
+    *matches = 0;
+    const HashPrefixIndex& index = snap.prefixes();
+    size_t first, last;
+    if (!index.find(prefix, &first, &last)) {
+        return false;
+    }
+    *matches = last - first;
+    for (size_t pos = first; pos < last && rows->size() < limit; ++pos) {
+        rows->push_back(index.row(pos));
+    }
+    return true;
+}
+
+bool lookup_hash_prefix(std::string_view prefix, size_t limit, std::vector<size_t>* rows, size_t* matches) {
+    return prefix_rows(*chain_snapshot(), prefix, limit, rows, matches);
+}
+
+// Prints the block if the prefix names exactly one, otherwise lists the
+// candidates so the user can paste a longer prefix.
+static void print_by_prefix(const ChainSnapshot& snap, const char* prefix) {
+    const BlockTable& chain = snap.table();
+    std::vector<size_t> rows;
+    size_t matches;
+    if (!prefix_rows(snap, prefix, LIST_LIMIT, &rows, &matches)) {
+        std::cerr << "Invalid hash prefix '" << prefix << "' (expected 1-64 hex digits)." << std::endl;
+        return;
+    }
+    if (matches == 0) {
+        std::cout << "No block hash starts with '" << prefix << "'." << std::endl;
+        return;
+    }
+    if (matches == 1) {
+        print_block(chain, rows[0]);
+        return;
+    }
+    BlockFormatter out;
+    out << "Hash prefix '" << prefix << "' is ambiguous: " << matches << " blocks match.";
+    out.line();
+    for (size_t i : rows) {
+        out << "  ";
+        out.hex(chain.hash(i)) << "  height: " << chain.height(i);
+        out.line();
+    }
+    if (matches > rows.size()) {
+        out << "  ... and " << matches - rows.size() << " more";
+        out.line();
+    }
+}
+
+void find_block_by_hash_prefix(const char* prefix) {
+    print_by_prefix(*chain_snapshot(), prefix);
+}
+
+// Finds a block by its height value via the height index.
+bool lookup_height(int height, size_t* row) {
+    return chain_snapshot()->find_height(height, row);
+}
+
 void find_block_by_height(int height) {
-    for (const auto& b : blockchain) {
-        if (b.height == height) {
-            std::cout << "hash: " << b.hash << std::endl;
-            std::cout << "height: " << b.height << std::endl;
-            std::cout << "total: " << b.total << std::endl;
-            std::cout << "time: " << b.time << std::endl;
-            std::cout << "relayed_by: " << b.relayed_by << std::endl;
-            std::cout << "prev_block: " << b.prev_block << std::endl;
-            return;
-        }
+    BlockRef b;
+    if (BlockQuery().find_height(height, &b)) {
+        BlockFormatter out;
+        out.block(b);
+        return;
     }
     std::cout << "Block with height '" << height << "' not found." << std::endl;
 }
 
 // Exports all blocks to a CSV file named infoutput.csv.
-// Assumes blockchain is already loaded into memory.
+// Assumes the chain is already loaded (see load_db()).
 void export_to_csv() {
-    std::ofstream output("infoutput.csv");
-    if (!output.is_open()) {
-        std::cerr << "Failed to create infoutput.csv" << std::endl;
-        return;
+    if (export_csv(CsvExportOptions())) {
+        std::cout << "Data exported to infoutput.csv successfully!" << std::endl;
     }
-    // Write CSV header
-    output << "hash,height,total,time,relayed_by,prev_block\n";
-    for (const auto& b : blockchain) {
-        output << b.hash << ","
-               << b.height << ","
-               << b.total << ","
-               << b.time << ","
-               << b.relayed_by << ","
-               << b.prev_block << "\n";
-    }
-    output.close();
-    std::cout << "Data exported to infoutput.csv successfully!" << std::endl;
 }
 
-void refresh_data() {
-    int blockCount = blockchain.size(); // Count how many blocks were loaded
+bool export_csv(const CsvExportOptions& options, CsvExportStats* stats) {
+    auto snap = chain_snapshot();
+    return write_csv(snap->table(), options, stats);
+}
 
-    std::cout << "Found " << blockCount << " blocks." << std::endl;
+// Appends blocks to info.txt in the same six-line layout blockchain1.sh writes.
+static bool append_to_txt(const std::string& path, const std::vector<Block>& blocks) {
+    std::ofstream out(path, std::ios::app);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << path << " for appending" << std::endl;
+        return false;
+    }
+    for (const auto& b : blocks) {
+        out << "  \"hash\": \"" << b.hash << "\",\n"
+            << "  \"height\": " << b.height << ",\n"
+            << "  \"total\": " << b.total << ",\n"
+            << "  \"time\": \"" << b.time << "\",\n"
+            << "  \"relayed_by\": \"" << b.relayed_by << "\",\n"
+            << "  \"prev_block\": \"" << b.prev_block << "\",\n"
+            << "\n\n\n\n";
+    }
+    return (bool)out;
+}
 
-    // Prepare the command string with the block count as an argument
-    std::string command = "./blockchain1.sh " + std::to_string(blockCount);
+// Legacy refresh: re-downloads `count` blocks with blockchain1.sh, which
+// rewrites info.txt, then reloads everything.
+// info.seg is a standalone copy for segquery.out, not read by load_db();
+// if there is one, it is rewritten from the refreshed chain (with its own
+// segment size) so it doesn't fall behind info.txt.
+static void resave_segments(const BlockTable& table) {
+    struct stat st;
+    if (stat(SEGSTORE_FILE, &st) != 0) return;
+    uint32_t segment_blocks = DEFAULT_SEGMENT_BLOCKS;
+    {
+        SegmentStore old;
+        if (old.open(SEGSTORE_FILE, 0)) segment_blocks = old.segment_blocks();
+    }
+    save_segments(table, SEGSTORE_FILE, segment_blocks);
+}
 
-    // Run the script
+static void refresh_with_script(int count) {
+    std::string command = "./blockchain1.sh " + std::to_string(count);
     int result = system(command.c_str());
-
     if (result == 0) {
         std::cout << "Script executed successfully." << std::endl;
+        load_db();
+        resave_segments(chain_snapshot()->table());
     } else {
         std::cout << "Script failed with code: " << result << std::endl;
     }
 }
+
+// Incremental refresh: fetches only the blocks newer than what is loaded
+// (walking prev_block from the API tip until a known hash), publishes a new
+// snapshot with them appended, and persists them. Queries keep using the
+// previous snapshot until then.
+// BLOCKCHAIN_REFRESH=script selects the old blockchain1.sh pipeline instead.
+void refresh_data() {
+    int blockCount = chain_snapshot()->size(); // Count how many blocks were loaded
+
+    std::cout << "Found " << blockCount << " blocks." << std::endl;
+
+    const char* mode = getenv("BLOCKCHAIN_REFRESH");
+    if (mode && strcmp(mode, "script") == 0) {
+        refresh_with_script(blockCount);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    std::shared_ptr<const ChainSnapshot> base = chain_snapshot();
+    const BlockTable& chain = base->table();
+    RefreshOptions options = default_refresh_options();
+    if (chain.empty()) {
+        options.max_blocks = INITIAL_REFRESH_BLOCKS;
+    }
+    int known_height = -1;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        known_height = std::max(known_height, chain.height(i));
+    }
+    std::vector<Block> fresh;
+    bool ok = fetch_new_blocks(options, [&base](const Hash32& h) { return base->contains(h); }, known_height,
+                               &fresh);
+
+    // Store oldest first, so the chain grows in the order blocks were mined.
+    std::vector<Block> added;
+    if (!fresh.empty()) {
+        std::reverse(fresh.begin(), fresh.end());
+        std::shared_ptr<ChainSnapshot> next = base->with_appended(fresh, &added);
+        publish_snapshot(next);
+        if (!added.empty()) {
+            append_to_txt("info.txt", added);
+            if (next->loaded_from_store()) {
+                save_store(next->table(), STORE_FILE);
+            }
+            resave_segments(next->table());
+        }
+    }
+
+    if (ok) {
+        std::cout << "Refresh done: " << added.size() << " new block(s)." << std::endl;
+    } else {
+        std::cout << "Refresh failed after " << added.size() << " new block(s)." << std::endl;
+    }
+}
+
+bool refresh_data_async() {
+    if (refreshing.exchange(true)) {
+        return false;  // One refresh at a time
+    }
+    if (refresh_thread.joinable()) {
+        refresh_thread.join();  // The previous one has finished
+    }
+    refresh_thread = std::thread([] {
+        refresh_data();
+        refreshing = false;
+    });
+    return true;
+}
+
+bool refresh_running() {
+    return refreshing;
+}
+
+void wait_for_refresh() {
+    if (refresh_thread.joinable()) {
+        refresh_thread.join();
+    }
+}
+
+bool query_range(int from, int to, RangeStats* out) {
+    return chain_snapshot()->ranges().stats(from, to, out);
+}
+
+std::vector<size_t> query_top_k(int from, int to, size_t k) {
+    return chain_snapshot()->ranges().top_k(from, to, k);
+}
+
+void print_range_stats(int from, int to) {
+    auto snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    RangeStats stats;
+    if (!snap->ranges().stats(from, to, &stats)) {
+        std::cout << "No blocks between heights " << from << " and " << to << "." << std::endl;
+        return;
+    }
+    std::cout << "heights: " << from << " - " << to << std::endl;
+    std::cout << "blocks: " << stats.count << std::endl;
+    std::cout << "sum: " << sum_to_string(stats.sum) << std::endl;
+    std::cout << "min: " << stats.min << " (height " << chain.height(stats.min_row) << ")" << std::endl;
+    std::cout << "max: " << stats.max << " (height " << chain.height(stats.max_row) << ")" << std::endl;
+    std::cout << std::fixed << std::setprecision(2) << "avg: " << stats.avg() << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+void print_top_k(int from, int to, int k) {
+    auto snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    std::vector<size_t> rows = snap->ranges().top_k(from, to, k < 0 ? 0 : (size_t)k);
+    if (rows.empty()) {
+        std::cout << "No blocks between heights " << from << " and " << to << "." << std::endl;
+        return;
+    }
+    BlockFormatter out;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        size_t i = rows[r];
+        out << r + 1 << ". height: " << chain.height(i) << "  total: " << chain.total(i) << "  hash: ";
+        out.hex(chain.hash(i)).line();
+    }
+}
+
+std::vector<size_t> query_time_range(int64_t from, int64_t to) {
+    return chain_snapshot()->times().range(from, to);
+}
+
+bool query_time_histogram(int64_t from, int64_t to, int64_t width, TimeHistogram* out) {
+    return chain_snapshot()->times().histogram(from, to, width, out);
+}
+
+void print_blocks_between(int64_t from, int64_t to) {
+    auto snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    std::vector<size_t> rows = snap->times().range(from, to);
+    BlockFormatter out;
+    out << "Found " << rows.size() << " blocks between ";
+    out.iso_time(from) << " and ";
+    out.iso_time(to) << ".";
+    out.line();
+    for (size_t i : rows) {
+        out.iso_time(chain.time(i)) << "  height: " << chain.height(i) << "  total: " << chain.total(i)
+                                    << "  hash: ";
+        out.hex(chain.hash(i)).line();
+    }
+}
+
+void print_time_histogram(int64_t from, int64_t to, int64_t width) {
+    TimeHistogram hist;
+    if (!query_time_histogram(from, to, width, &hist)) {
+        std::cout << "No blocks between " << format_iso_time(from) << " and " << format_iso_time(to)
+                  << " (or too many buckets)." << std::endl;
+        return;
+    }
+    BlockFormatter out;
+    for (size_t b = 0; b < hist.blocks.size(); ++b) {
+        out.iso_time(hist.start + (int64_t)b * hist.width) << "  blocks: " << hist.blocks[b]
+                                                          << "  total: " << sum_to_string(hist.totals[b]);
+        out.line();
+    }
+}
+
+bool query_ancestor(size_t row, uint32_t depth, size_t* out) {
+    uint32_t slot = chain_snapshot()->links().ancestor(row, depth);
+    if (slot == NO_SLOT) return false;
+    *out = slot;
+    return true;
+}
+
+bool query_common_ancestor(size_t a, size_t b, size_t* out) {
+    uint32_t slot = chain_snapshot()->links().common_ancestor(a, b);
+    if (slot == NO_SLOT) return false;
+    *out = slot;
+    return true;
+}
+
+bool query_is_ancestor(size_t ancestor, size_t row) {
+    auto snap = chain_snapshot();
+    const ChainIndex& index = snap->links();
+    if (ancestor >= index.size() || row >= index.size() || index.depth(ancestor) > index.depth(row)) {
+        return false;
+    }
+    return index.ancestor(row, index.depth(row) - index.depth(ancestor)) == ancestor;
+}
+
+ChainReport query_chain_report() {
+    return chain_snapshot()->links().report();
+}
+
+// Resolves a full hash or an unambiguous prefix, explaining on stdout why
+// it couldn't.
+static bool resolve_hash_arg(const ChainSnapshot& snap, const char* hash, size_t* row) {
+    if (strlen(hash) == 64) {
+        if (snap.find_hash(hash, row)) return true;
+        std::cout << "Block with hash '" << hash << "' not found." << std::endl;
+        return false;
+    }
+    std::vector<size_t> rows;
+    size_t matches;
+    if (prefix_rows(snap, hash, 1, &rows, &matches) && matches == 1) {
+        *row = rows[0];
+        return true;
+    }
+    print_by_prefix(snap, hash);  // Prints why (invalid, none, ambiguous)
+    return false;
+}
+
+void print_ancestor(const char* hash, int depth) {
+    auto snap = chain_snapshot();
+    size_t row;
+    if (depth < 0) {
+        std::cerr << "Invalid depth " << depth << "." << std::endl;
+        return;
+    }
+    if (!resolve_hash_arg(*snap, hash, &row)) return;
+    uint32_t found = snap->links().ancestor(row, (uint32_t)depth);
+    if (found == NO_SLOT) {
+        std::cout << "Only " << snap->links().depth(row) << " loaded block(s) before height "
+                  << snap->table().height(row) << "; can't go back " << depth << "." << std::endl;
+        return;
+    }
+    print_block(snap->table(), found);
+}
+
+void print_common_ancestor(const char* hash_a, const char* hash_b) {
+    auto snap = chain_snapshot();
+    size_t a, b;
+    if (!resolve_hash_arg(*snap, hash_a, &a) || !resolve_hash_arg(*snap, hash_b, &b)) return;
+    uint32_t found = snap->links().common_ancestor(a, b);
+    if (found == NO_SLOT) {
+        std::cout << "The two blocks share no loaded ancestor." << std::endl;
+        return;
+    }
+    if (found == a) {
+        std::cout << "The first block is an ancestor of the second." << std::endl;
+    } else if (found == b) {
+        std::cout << "The second block is an ancestor of the first." << std::endl;
+    }
+    print_block(snap->table(), found);
+}
+
+void print_chain_report() {
+    auto snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    const ChainReport& report = snap->links().report();
+    std::cout << "blocks: " << report.blocks << std::endl;
+    std::cout << "longest branch: " << (report.blocks ? snap->links().depth(report.tip) + 1 : 0) << " blocks";
+    if (report.blocks) std::cout << ", tip height " << chain.height(report.tip);
+    std::cout << std::endl;
+    std::cout << "gaps: " << report.gaps.size() << std::endl;
+    for (size_t r = 0; r < report.gaps.size() && r < LIST_LIMIT; ++r) {
+        size_t i = report.gaps[r];
+        std::cout << "  missing prev_block " << chain.prev_block_hex(i) << " of height " << chain.height(i)
+                  << std::endl;
+    }
+    std::cout << "forks: " << report.forks.size() << std::endl;
+    for (size_t r = 0; r < report.forks.size() && r < LIST_LIMIT; ++r) {
+        size_t i = report.forks[r];
+        std::cout << "  height " << chain.height(i) << " " << chain.hash_hex(i) << std::endl;
+    }
+}
+
+ValidationReport chain_validation() {
+    return chain_snapshot()->validation();
+}
+
+void print_validation_report() {
+    auto snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+    const ValidationReport& r = snap->validation();
+    std::cout << "blocks: " << r.blocks;
+    if (r.blocks) std::cout << " (heights " << r.min_height << " - " << r.max_height << ")";
+    std::cout << std::endl;
+    std::cout << "malformed blocks skipped: " << r.skipped << std::endl;
+    std::cout << "gaps: " << r.gaps << " (" << r.missing_heights << " missing heights)" << std::endl;
+    std::cout << "broken links: " << r.broken_links << std::endl;
+    std::cout << "duplicate hashes: " << r.duplicate_hashes << std::endl;
+    std::cout << "duplicate heights: " << r.duplicate_heights << std::endl;
+    for (const ChainIssue& issue : r.issues) {
+        std::cout << "  " << issue_name(issue.kind) << " at height " << issue.height;
+        if (issue.kind == ISSUE_GAP) {
+            std::cout << ": " << issue.other << " height(s) missing";
+        } else if (issue.kind == ISSUE_BROKEN_LINK) {
+            std::cout << ": prev_block " << chain.prev_block_hex(issue.row) << " but height "
+                      << chain.height(issue.other) << " is " << chain.hash_hex(issue.other);
+        } else {
+            std::cout << ": " << chain.hash_hex(issue.row) << " (first seen as " << chain.hash_hex(issue.other)
+                      << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << (r.ok() ? "chain OK" : "chain has issues") << " (checked in " << std::fixed << std::setprecision(2)
+              << r.milliseconds << " ms)" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
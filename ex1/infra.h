@@ -2,35 +2,92 @@
 #define INFRA_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>  // Add this at the top
+#include "chain.h"
+#include "infra_c.h"  // the C interface and the original entry points
 
-struct Block {
-    std::string hash;
-    int height;
-    int64_t total;  // Changed from int to int64_t
-    std::string time;
-    std::string relayed_by;
-    std::string prev_block;
-};
+class ChainSnapshot;
 
-extern std::vector<Block> blockchain;
+// The loaded chain (compact column layout, see chain.h) with its indexes, as
+// an immutable snapshot (see snapshot.h). load_db() and refresh_data()
+// publish a new one instead of changing it, so a reader that holds a
+// snapshot sees one consistent chain however long it takes.
+std::shared_ptr<const ChainSnapshot> chain_snapshot();
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// Parses a text info.txt into `out`. Returns false if the file can't be opened.
+// `skipped`, if given, gets the number of malformed blocks left out.
+bool load_txt(const std::string& path, BlockTable& out, size_t* skipped = nullptr);
+
+// Replaces the loaded chain with the blocks of a CSV written by ex3.out
+// (see csvimport.h), parsed on every core. Returns false if the file can't
+// be read or has no usable header; the chain is left as it was.
+bool load_csv(const std::string& path);
+
+// Row of the block with this hex hash / height, without printing.
+// Safe to call from several threads, also during load_db()/refresh_data().
+// Rows (here and below) refer to the snapshot current at the call; code that
+// must not see a reload between two calls should hold a snapshot and use its
+// members instead.
+bool lookup_hash(std::string_view hex, size_t* row);
+bool lookup_height(int height, size_t* row);
+// Rows of the blocks whose hex hash starts with `prefix` (1-64 hex digits,
+// either case), in hash order, for pasted truncated hashes. At most `limit`
+// rows are returned; `*matches` gets the full count, so more than one means
+// the prefix is ambiguous. Returns false if `prefix` isn't a hex prefix.
+bool lookup_hash_prefix(std::string_view prefix, size_t limit, std::vector<size_t>* rows, size_t* matches);
+
+struct RangeStats;
+
+// Aggregates of `total` over blocks with from <= height <= to (see
+// rangeindex.h). The index is built on first use after a load or refresh.
+// Returns false if no block is in the range.
+bool query_range(int from, int to, RangeStats* out);
+// Table rows of the k largest totals in [from, to], largest first.
+std::vector<size_t> query_top_k(int from, int to, size_t k);
+
+struct TimeHistogram;
+
+// Table rows of blocks mined between two epoch times (inclusive), oldest
+// first, and per-bucket counts/sums (see timeindex.h). Indexed on first use.
+std::vector<size_t> query_time_range(int64_t from, int64_t to);
+bool query_time_histogram(int64_t from, int64_t to, int64_t width, TimeHistogram* out);
+
+struct ChainReport;
+
+// Walks over prev_block links (see chainindex.h), indexed on first use.
+// The block `depth` blocks before `row` (0 is `row` itself); false if that
+// is past the oldest loaded ancestor.
+bool query_ancestor(size_t row, uint32_t depth, size_t* out);
+// The newest block both rows descend from; false if there is none loaded.
+bool query_common_ancestor(size_t a, size_t b, size_t* out);
+bool query_is_ancestor(size_t ancestor, size_t row);
+// Gaps and forks found while linking the chain.
+ChainReport query_chain_report();
+
+struct ValidationReport;
+
+// Integrity check of the chain as loaded (see validate.h): gaps, broken
+// prev_block links and duplicates. Run by load_db() and after a refresh.
+ValidationReport chain_validation();
+
+struct CsvExportOptions;
+struct CsvExportStats;
+
+// CSV export with a chosen path, columns, height range and optional gzip
+// (see csvexport.h); export_to_csv() is this with the defaults.
+bool export_csv(const CsvExportOptions& options, CsvExportStats* stats = nullptr);
+
+// Runs refresh_data() on a background thread; queries keep answering from
+// the current snapshot until the refreshed one is published. Returns false
+// if a refresh is already running.
+bool refresh_data_async();
+bool refresh_running();
+// Waits for a background refresh to finish (call before exiting).
+void wait_for_refresh();
 
 std::string cleanLine(const std::string& line);
 int countBlocks(const std::string& filename);
-void load_db();  // Removed the argument x
-void print_db();
-void find_block_by_hash(const char* hash);
-void find_block_by_height(int height);
-void export_to_csv();
-void refresh_data();
-
-#ifdef __cplusplus
-}
-#endif
 
 #endif // INFRA_H
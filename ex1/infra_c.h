@@ -0,0 +1,62 @@
+#ifndef INFRA_C_H
+#define INFRA_C_H
+
+// The part of libinfra callable from C (infra.h includes it for C++).
+// Include this one from C code; cblock.c is an example.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Result-returning C interface (blockview.h is the C++ one). A handle pins
+// the chain as it was when acquired; the pointers in an InfraBlock point
+// into it and stay valid until infra_release(), whatever reloads happen
+// meanwhile. Lookups return 1 if found, 0 if not; nothing is printed.
+typedef struct InfraSnapshot InfraSnapshot;
+typedef struct InfraBlock {
+    const uint8_t* hash;        // 32 raw bytes, hex string order
+    const uint8_t* prev_block;  // 32 raw bytes
+    const char* relayed_by;     // NUL-terminated
+    int64_t total;
+    int64_t time;               // seconds since the epoch (UTC)
+    int64_t fees;               // -1 if unknown
+    int32_t height;
+    int32_t n_tx;               // -1 if unknown
+    int32_t size;               // -1 if unknown
+    uint32_t row;
+} InfraBlock;
+
+InfraSnapshot* infra_acquire(void);
+void infra_release(InfraSnapshot* snapshot);
+size_t infra_block_count(const InfraSnapshot* snapshot);
+int infra_block_at(const InfraSnapshot* snapshot, size_t row, InfraBlock* out);
+int infra_find_hash(const InfraSnapshot* snapshot, const char* hex, InfraBlock* out);
+int infra_find_height(const InfraSnapshot* snapshot, int height, InfraBlock* out);
+// Rows of the blocks with from <= height <= to, in height order: `*rows`
+// is set to the first of the returned count (read them with infra_block_at).
+size_t infra_height_range(const InfraSnapshot* snapshot, int from, int to, const uint32_t** rows);
+
+void load_db(void);  // Removed the argument x
+void print_db(void);
+void find_block_by_hash(const char* hash);
+void find_block_by_hash_prefix(const char* prefix);
+void find_block_by_height(int height);
+void export_to_csv(void);
+void refresh_data(void);
+void print_range_stats(int from, int to);
+void print_top_k(int from, int to, int k);
+void print_blocks_between(int64_t from, int64_t to);
+void print_time_histogram(int64_t from, int64_t to, int64_t width);
+void print_ancestor(const char* hash, int depth);
+void print_common_ancestor(const char* hash_a, const char* hash_b);
+void print_chain_report(void);
+void print_validation_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INFRA_C_H
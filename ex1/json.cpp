@@ -0,0 +1,447 @@
+#include "json.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+struct FieldName {
+    std::string_view name;
+    uint32_t field;
+};
+
+const FieldName FIELD_NAMES[] = {
+    {"hash", FIELD_HASH},     {"height", FIELD_HEIGHT},         {"total", FIELD_TOTAL},
+    {"time", FIELD_TIME},     {"relayed_by", FIELD_RELAYED_BY}, {"prev_block", FIELD_PREV_BLOCK},
+    {"n_tx", FIELD_N_TX},     {"fees", FIELD_FEES},             {"size", FIELD_SIZE},
+};
+
+uint32_t field_for(std::string_view key) {
+    for (const auto& f : FIELD_NAMES) {
+        if (f.name == key) return f.field;
+    }
+    return 0;
+}
+
+const char* name_of(uint32_t field) {
+    for (const auto& f : FIELD_NAMES) {
+        if (f.field == field) return f.name.data();
+    }
+    return "?";
+}
+
+// Bit i of the result is set if byte i of the 64-byte window is `c`, and so on.
+struct CharMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;    // { } [ ] : ,
+    uint64_t newline;
+};
+
+inline CharMasks classify(const char* p) {
+    CharMasks m;
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');    // '[' | 0x20
+    const __m128i close = _mm_set1_epi8('}');   // ']' | 0x20
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    m.quote = m.backslash = m.op = m.newline = 0;
+    for (int k = 0; k < 4; ++k) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+        __m128i folded = _mm_or_si128(v, lower);
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        m.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << (16 * k);
+        m.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << (16 * k);
+        m.op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << (16 * k);
+        m.newline |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)) << (16 * k);
+    }
+#else
+    m.quote = m.backslash = m.op = m.newline = 0;
+    for (int i = 0; i < 64; ++i) {
+        char c = p[i];
+        uint64_t bit = 1ull << i;
+        if (c == '"') m.quote |= bit;
+        else if (c == '\\') m.backslash |= bit;
+        else if (c == '\n') m.newline |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') m.op |= bit;
+    }
+#endif
+    return m;
+}
+
+// Bit i set if an odd number of bits at or below i are set in x.
+inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Stage one: yields the positions of structural characters in order,
+// producing them a batch of 64-byte blocks at a time so memory use does
+// not grow with the input.
+class StructuralScanner {
+public:
+    explicit StructuralScanner(std::string_view text) : text_(text) {}
+
+    bool next(size_t* pos) {
+        if (head_ == tail_ && !fill()) return false;
+        *pos = positions_[head_++];
+        return true;
+    }
+
+private:
+    static const int BATCH_BLOCKS = 16;
+
+    bool fill() {
+        head_ = tail_ = 0;
+        for (int b = 0; offset_ < text_.size() && (b < BATCH_BLOCKS || tail_ == 0); ++b, offset_ += 64) {
+            const char* p = text_.data() + offset_;
+            char last[64];
+            if (text_.size() - offset_ < 64) {
+                memset(last, ' ', sizeof(last));
+                memcpy(last, p, text_.size() - offset_);
+                p = last;
+            }
+            CharMasks m = classify(p);
+
+            // Escapes are rare; only look at them byte by byte when present.
+            uint64_t escaped = 0;
+            if (m.backslash || escaped_) {
+                for (int i = 0; i < 64; ++i) {
+                    if (escaped_) {
+                        escaped |= 1ull << i;
+                        escaped_ = false;
+                    } else if (m.backslash >> i & 1) {
+                        escaped_ = true;
+                    }
+                }
+            }
+            uint64_t quote = m.quote & ~escaped;
+            uint64_t in_string = prefix_xor(quote) ^ in_string_;
+            if (m.newline & in_string) {
+                // Strings can't span lines, so this is a broken document.
+                // Restart outside a string at each newline so the following
+                // NDJSON records still scan correctly.
+                in_string = 0;
+                bool in = in_string_ != 0;
+                for (int i = 0; i < 64; ++i) {
+                    if (m.newline >> i & 1) in = false;
+                    if (quote >> i & 1) in = !in;
+                    if (in) in_string |= 1ull << i;
+                }
+            }
+            in_string_ = (uint64_t)((int64_t)in_string >> 63);
+
+            uint64_t structural = (m.op & ~in_string) | quote;
+            while (structural) {
+                positions_[tail_++] = offset_ + __builtin_ctzll(structural);
+                structural &= structural - 1;
+            }
+        }
+        return tail_ > 0;
+    }
+
+    std::string_view text_;
+    size_t offset_ = 0;
+    uint64_t in_string_ = 0;   // all ones if the last block ended inside a string
+    bool escaped_ = false;     // the last block ended with an unescaped backslash
+    size_t positions_[(BATCH_BLOCKS + 1) * 64];
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\n' || s.front() == '\r')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\n' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+template <typename T>
+bool parse_number(std::string_view s, T* out) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), *out);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+// One block document as it is being read.
+struct Record {
+    uint32_t seen = 0;
+    Hash32 hash;
+    Hash32 prev_block = {};
+    int height = -1;
+    int64_t total = -1;
+    int64_t time = 0;
+    std::string_view relayed_by;
+    int n_tx = -1;
+    int64_t fees = -1;
+    int size = -1;
+    const char* error = nullptr;
+    uint32_t error_field = 0;
+};
+
+const uint32_t STRING_FIELDS = FIELD_HASH | FIELD_TIME | FIELD_RELAYED_BY | FIELD_PREV_BLOCK;
+const uint32_t REQUIRED_FIELDS = FIELD_HASH | FIELD_HEIGHT | FIELD_TOTAL | FIELD_TIME | FIELD_PREV_BLOCK;
+
+void set_field(Record& r, uint32_t field, std::string_view value, bool is_string) {
+    if (r.error) return;
+    bool ok;
+    if (!is_string && value == "null") {
+        ok = true;  // Same as absent
+        field = 0;
+    } else if (is_string != ((field & STRING_FIELDS) != 0)) {
+        ok = false;
+    } else {
+        switch (field) {
+            case FIELD_HASH: ok = from_hex(value, r.hash.bytes, 32); break;
+            case FIELD_PREV_BLOCK: ok = from_hex(value, r.prev_block.bytes, 32); break;
+            case FIELD_TIME: ok = parse_iso_time(value, &r.time); break;
+            case FIELD_RELAYED_BY: r.relayed_by = value; ok = true; break;
+            case FIELD_HEIGHT: ok = parse_number(value, &r.height); break;
+            case FIELD_TOTAL: ok = parse_number(value, &r.total); break;
+            case FIELD_N_TX: ok = parse_number(value, &r.n_tx); break;
+            case FIELD_FEES: ok = parse_number(value, &r.fees); break;
+            case FIELD_SIZE: ok = parse_number(value, &r.size); break;
+            default: ok = true; break;
+        }
+    }
+    if (!ok) {
+        r.error = "bad value for ";
+        r.error_field = field;
+    }
+    r.seen |= field;
+}
+
+// Stage two: walks the structural positions and fills the table.
+class BlockReader {
+public:
+    BlockReader(std::string_view text, uint32_t fields, BlockTable& out, ParseReport* report)
+        : text_(text), scanner_(text), fields_(fields | FIELD_HASH), out_(out), report_(report) {}
+
+    void run() {
+        size_t p;
+        bool have = next(&p);
+        while (have) {
+            char c = text_[p];
+            if (c == '[' || c == ']' || c == ',') {
+                have = next(&p);  // Top-level array of documents
+            } else if (c == '{' && read_block(p_open_ = p)) {
+                have = next(&p);
+            } else {
+                if (c != '{') issue(p, "unexpected '" + std::string(1, c) + "' between documents");
+                // The position that broke the document may itself start the next one.
+                p = last_;
+                have = (last_ != p_open_ && at_line_start(p)) || resync(&p);
+            }
+        }
+    }
+
+private:
+    // Reads the object opening at `open`. Returns false if the structure is
+    // broken; a well-formed document with bad values is reported and skipped.
+    bool read_block(size_t open) {
+        Record r;
+        size_t p;
+        if (!next(&p)) return broken(open, "unterminated document");
+        if (text_[p] != '}') {
+            for (;;) {
+                size_t key_open = p;
+                if (text_[p] != '"') return broken(open, "expected a member name");
+                if (!next(&p) || text_[p] != '"') return broken(open, "unterminated member name");
+                std::string_view key = text_.substr(key_open + 1, p - key_open - 1);
+                if (!next(&p) || text_[p] != ':') return broken(open, "expected ':'");
+
+                size_t v = p + 1;
+                while (v < text_.size() && (text_[v] == ' ' || text_[v] == '\t' || text_[v] == '\n' || text_[v] == '\r')) {
+                    ++v;
+                }
+                uint32_t field = field_for(key) & fields_;
+                char c = v < text_.size() ? text_[v] : '\0';
+                if (c == '"') {
+                    if (!next(&p) || p != v || !next(&p)) {
+                        return broken(open, "unterminated string");
+                    }
+                    if (field) set_field(r, field, text_.substr(v + 1, p - v - 1), true);
+                    if (!next(&p)) return broken(open, "unterminated document");
+                } else if (c == '{' || c == '[') {
+                    if (!skip_nested(v) || !next(&p)) return broken(open, "unterminated value");
+                    if (field && !r.error) {
+                        r.error = "expected a scalar for ";
+                        r.error_field = field;
+                    }
+                } else {
+                    if (!next(&p)) return broken(open, "unterminated document");
+                    if (field) set_field(r, field, trim(text_.substr(v, p - v)), false);
+                }
+
+                if (text_[p] == '}') break;
+                if (text_[p] != ',' || !next(&p)) return broken(open, "expected ',' or '}'");
+            }
+        }
+
+        uint32_t missing = (fields_ & REQUIRED_FIELDS) & ~r.seen;
+        if (!r.error && missing) {
+            r.error = "missing ";
+            r.error_field = missing & (0 - missing);  // Lowest missing field
+        }
+        if (r.error) {
+            ++report_->skipped;
+            issue(open, std::string(r.error) + name_of(r.error_field));
+            return true;
+        }
+        out_.append(r.hash, r.height, r.total, r.time, r.relayed_by, r.prev_block, r.n_tx, r.fees, r.size);
+        ++report_->blocks;
+        return true;
+    }
+
+    // Skips the object or array opening at `open` (already the next position).
+    bool skip_nested(size_t open) {
+        size_t p;
+        if (!next(&p) || p != open) return false;
+        int depth = 1;
+        while (depth > 0) {
+            if (!next(&p)) return false;
+            char c = text_[p];
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') --depth;
+        }
+        return true;
+    }
+
+    bool broken(size_t open, const char* message) {
+        ++report_->skipped;
+        issue(open, message);
+        return false;
+    }
+
+    bool next(size_t* pos) {
+        if (!scanner_.next(pos)) return false;
+        last_ = *pos;
+        return true;
+    }
+
+    bool at_line_start(size_t pos) const {
+        if (text_[pos] != '{') return false;
+        while (pos > 0 && (text_[pos - 1] == ' ' || text_[pos - 1] == '\t')) --pos;
+        return pos == 0 || text_[pos - 1] == '\n';
+    }
+
+    // After a broken document, continues at the next '{' that starts a line
+    // (the next NDJSON record). Returns false at the end of the input.
+    bool resync(size_t* pos) {
+        while (next(pos)) {
+            if (at_line_start(*pos)) return true;
+        }
+        return false;
+    }
+
+    void issue(size_t pos, const std::string& message) {
+        if (report_->issues.size() >= ParseReport::MAX_PARSE_ISSUES) return;
+        // Issues come in input order, so lines are counted incrementally.
+        const char* base = text_.data();
+        for (const char* nl; (nl = static_cast<const char*>(memchr(base + line_pos_, '\n', pos - line_pos_)));) {
+            ++line_;
+            line_pos_ = nl - base + 1;
+        }
+        report_->issues.push_back({line_, message});
+    }
+
+    std::string_view text_;
+    StructuralScanner scanner_;
+    uint32_t fields_;
+    BlockTable& out_;
+    ParseReport* report_;
+    size_t line_ = 1;
+    size_t line_pos_ = 0;
+    size_t last_ = 0;       // last structural position handed out
+    size_t p_open_ = 0;     // start of the document being read
+};
+
+} // namespace
+
+uint32_t block_field(std::string_view name) {
+    return field_for(name);
+}
+
+const char* block_field_name(uint32_t field) {
+    return name_of(field);
+}
+
+bool parse_field_list(std::string_view list, uint32_t* fields) {
+    *fields = FIELD_HASH;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view name = trim(list.substr(0, comma));
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        if (name == "all") {
+            *fields |= FIELDS_ALL;
+        } else if (uint32_t f = field_for(name)) {
+            *fields |= f;
+        } else if (!name.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void parse_json_blocks(std::string_view text, uint32_t fields, BlockTable& out, ParseReport* report) {
+    BlockReader reader(text, fields, out, report);
+    reader.run();
+}
+
+bool parse_json_file(const std::string& path, uint32_t fields, BlockTable& out, ParseReport* report) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    parse_json_blocks(std::string_view(static_cast<const char*>(map), st.st_size), fields, out, report);
+    munmap(map, st.st_size);
+    return true;
+}
+
+bool looks_like_json(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char buf[256];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+    for (ssize_t i = 0; i < n; ++i) {
+        if (buf[i] == ' ' || buf[i] == '\t' || buf[i] == '\n' || buf[i] == '\r') continue;
+        return buf[i] == '{' || buf[i] == '[';
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "chain.h"
+#include "parser.h"
+
+// Fast ingestion of BlockCypher block documents (GET /blocks/<hash>) into a
+// BlockTable. Accepts a single document, a JSON array of documents, or
+// NDJSON (one document per line), so the API output can be saved as is
+// instead of cutting fixed line numbers out of it with sed.
+//
+// Parsing is done in two passes in the style of simdjson: the first finds
+// the structural characters ({}[]:, and unescaped quotes outside strings)
+// 64 bytes at a time with SSE2 compares and bit tricks, the second walks
+// only those positions, so members that aren't wanted (txids, mrkl_root,
+// ...) are skipped without looking at their bytes. Member order does not
+// matter. Malformed documents are skipped and reported in the ParseReport;
+// issue lines are the line where the document starts.
+
+enum BlockField : uint32_t {
+    FIELD_HASH = 1u << 0,
+    FIELD_HEIGHT = 1u << 1,
+    FIELD_TOTAL = 1u << 2,
+    FIELD_TIME = 1u << 3,
+    FIELD_RELAYED_BY = 1u << 4,
+    FIELD_PREV_BLOCK = 1u << 5,
+    FIELD_N_TX = 1u << 6,
+    FIELD_FEES = 1u << 7,
+    FIELD_SIZE = 1u << 8,
+};
+
+// The six fields info.txt has, and everything BlockTable can hold.
+const uint32_t FIELDS_INFO = FIELD_HASH | FIELD_HEIGHT | FIELD_TOTAL | FIELD_TIME |
+                             FIELD_RELAYED_BY | FIELD_PREV_BLOCK;
+const uint32_t FIELDS_ALL = FIELDS_INFO | FIELD_N_TX | FIELD_FEES | FIELD_SIZE;
+
+// The BlockField for a member name ("n_tx"), 0 if unknown, and back.
+uint32_t block_field(std::string_view name);
+const char* block_field_name(uint32_t field);
+
+// Parses a comma separated list of member names ("hash,height,n_tx") or
+// "all". The hash is always included. Returns false on an unknown name.
+bool parse_field_list(std::string_view list, uint32_t* fields);
+
+// Appends every well-formed block document in `text` to `out`. Fields not
+// in `fields` are not parsed and keep their unknown value (-1, or 0 for the
+// time and an all-zero prev_block). The hash is required, as are the
+// height, total, time and prev_block when selected.
+void parse_json_blocks(std::string_view text, uint32_t fields, BlockTable& out, ParseReport* report);
+
+// Maps `path` and parses it. Returns false if the file can't be opened.
+bool parse_json_file(const std::string& path, uint32_t fields, BlockTable& out, ParseReport* report);
+
+// True if the first non-blank byte of `path` is '{' or '['.
+bool looks_like_json(const std::string& path);
+
+#endif // JSON_H
@@ -0,0 +1,180 @@
+#include "parser.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char* const FIELD_NAMES[6] = {"hash", "height", "total", "time", "relayed_by", "prev_block"};
+const int FIELD_COUNT = 6;
+
+// Trims spaces, tabs and a trailing '\r'.
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// Splits `"key": value,` into key and value (quotes and the trailing comma removed).
+bool split_field(std::string_view line, std::string_view* key, std::string_view* value) {
+    line = trim(line);
+    if (line.size() < 3 || line.front() != '"') return false;
+    size_t key_end = line.find('"', 1);
+    if (key_end == std::string_view::npos) return false;
+    *key = line.substr(1, key_end - 1);
+
+    std::string_view rest = trim(line.substr(key_end + 1));
+    if (rest.empty() || rest.front() != ':') return false;
+    rest = trim(rest.substr(1));
+    if (!rest.empty() && rest.back() == ',') rest = trim(rest.substr(0, rest.size() - 1));
+    if (rest.size() >= 2 && rest.front() == '"' && rest.back() == '"') {
+        rest = rest.substr(1, rest.size() - 2);
+    }
+    *value = rest;
+    return true;
+}
+
+template <typename T>
+bool parse_number(std::string_view s, T* out) {
+    const char* end = s.data() + s.size();
+    std::from_chars_result r = std::from_chars(s.data(), end, *out);
+    return r.ec == std::errc() && r.ptr == end;
+}
+
+// Fields of the block being assembled; views point into the mapped text.
+struct PendingBlock {
+    Hash32 hash;
+    Hash32 prev_block;
+    int height;
+    int64_t total;
+    int64_t time;
+    std::string_view relayed_by;
+    int next_field;         // index into FIELD_NAMES, FIELD_COUNT when done
+    size_t first_line;
+    bool bad;               // an issue was reported; drop at the next "hash"
+};
+
+class Parser {
+public:
+    Parser(BlockTable& out, ParseReport* report) : out_(out), report_(report) {
+        pending_.next_field = 0;
+        pending_.bad = false;
+        pending_.first_line = 0;
+        started_ = false;
+    }
+
+    void line(size_t number, std::string_view text) {
+        std::string_view key, value;
+        if (!split_field(text, &key, &value)) {
+            fail(number, "expected a \"key\": value line");
+            return;
+        }
+        if (key == FIELD_NAMES[0]) {
+            finish(number);
+            pending_.next_field = 0;
+            pending_.bad = false;
+            pending_.first_line = number;
+            started_ = true;
+        }
+        if (!started_ || pending_.bad) return;
+        if (pending_.next_field >= FIELD_COUNT || key != FIELD_NAMES[pending_.next_field]) {
+            fail(number, std::string("unexpected field \"") + std::string(key) + "\"");
+            return;
+        }
+
+        bool ok = true;
+        switch (pending_.next_field) {
+            case 0: ok = from_hex(value, pending_.hash.bytes, 32); break;
+            case 1: ok = parse_number(value, &pending_.height); break;
+            case 2: ok = parse_number(value, &pending_.total); break;
+            case 3: ok = parse_iso_time(value, &pending_.time); break;
+            case 4: pending_.relayed_by = value; break;
+            case 5: ok = from_hex(value, pending_.prev_block.bytes, 32); break;
+        }
+        if (!ok) {
+            fail(number, std::string("malformed ") + FIELD_NAMES[pending_.next_field]);
+            return;
+        }
+        if (++pending_.next_field == FIELD_COUNT) {
+            out_.append(pending_.hash, pending_.height, pending_.total, pending_.time,
+                        pending_.relayed_by, pending_.prev_block);
+            if (report_) ++report_->blocks;
+            started_ = false;
+        }
+    }
+
+    // Called at the start of the next block and at end of input.
+    void finish(size_t number) {
+        if (started_ && !pending_.bad && pending_.next_field < FIELD_COUNT) {
+            fail(number, "incomplete block");
+        }
+        started_ = false;
+    }
+
+private:
+    void fail(size_t number, const std::string& message) {
+        if (!started_ || pending_.bad) return;  // One issue per block
+        pending_.bad = true;
+        if (!report_) return;
+        ++report_->skipped;
+        if (report_->issues.size() < ParseReport::MAX_PARSE_ISSUES) {
+            report_->issues.push_back(ParseIssue{number, message});
+        }
+    }
+
+    BlockTable& out_;
+    ParseReport* report_;
+    PendingBlock pending_;
+    bool started_;
+};
+
+} // namespace
+
+void parse_info_text(std::string_view text, BlockTable& out, ParseReport* report) {
+    // A block takes roughly 330 bytes of text; reserve up front to avoid regrowth.
+    out.reserve(out.size() + text.size() / 300 + 1);
+
+    Parser parser(out, report);
+    size_t number = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        ++number;
+        std::string_view line = trim(std::string_view(p, line_end - p));
+        if (!line.empty()) {
+            parser.line(number, line);
+        }
+        p = nl ? nl + 1 : end;
+    }
+    parser.finish(number);
+}
+
+bool parse_info_file(const std::string& path, BlockTable& out, ParseReport* report) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    parse_info_text(std::string_view(static_cast<const char*>(map), st.st_size), out, report);
+    munmap(map, st.st_size);
+    return true;
+}
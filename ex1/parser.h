@@ -0,0 +1,38 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chain.h"
+
+// Zero-copy parser for the info.txt format written by blockchain1.sh:
+// blocks of six `"key": value,` lines (hash, height, total, time,
+// relayed_by, prev_block) separated by blank lines.
+//
+// The whole file is mapped once and sliced with std::string_view; numbers
+// go through std::from_chars and hashes/times are decoded in place, so no
+// memory is allocated per line. Malformed blocks are skipped and reported
+// instead of throwing.
+
+struct ParseIssue {
+    size_t line;            // 1-based line number
+    std::string message;
+};
+
+struct ParseReport {
+    size_t blocks = 0;      // blocks appended to the table
+    size_t skipped = 0;     // blocks dropped because of an issue
+    std::vector<ParseIssue> issues;  // the first MAX_PARSE_ISSUES issues
+
+    static const size_t MAX_PARSE_ISSUES = 32;
+};
+
+// Parses `text` and appends every well-formed block to `out`.
+void parse_info_text(std::string_view text, BlockTable& out, ParseReport* report);
+
+// Maps `path` and parses it. Returns false if the file can't be opened.
+bool parse_info_file(const std::string& path, BlockTable& out, ParseReport* report);
+
+#endif // PARSER_H
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+#include <climits>
+#include <cstdint>
+#include "infra.h"
+#include "timeindex.h"
+
+// Range queries over the loaded chain:
+//   stats <from> <to>     - count/sum/min/max/avg of total for those heights
+//   top <k> [<from> <to>] - the k blocks with the largest total
+//   between <t1> <t2>     - blocks mined between two times
+//   histogram <minute|hour|day> [<t1> <t2>] - blocks and summed total per bucket
+//   ancestor <hash> <n>   - the block n blocks before the given one
+//   common <hash> <hash>  - the newest block both descend from
+//   chain                 - gaps and forks in the loaded chain
+//   validate              - integrity check done at load (gaps, links, duplicates)
+// Hashes may be abbreviated to any unambiguous prefix.
+// Times are "YYYY-MM-DDTHH:MM:SSZ" or just "YYYY-MM-DD" (start/end of day).
+static void usage(const char* program) {
+    std::cout << "Usage:\n"
+              << "  " << program << " stats <from_height> <to_height>\n"
+              << "  " << program << " top <k> [<from_height> <to_height>]\n"
+              << "  " << program << " between <from_time> <to_time>\n"
+              << "  " << program << " histogram <minute|hour|day> [<from_time> <to_time>]\n"
+              << "  " << program << " ancestor <hash> <n>\n"
+              << "  " << program << " common <hash> <hash>\n"
+              << "  " << program << " chain\n"
+              << "  " << program << " validate\n";
+}
+
+static bool parse_time_arg(const std::string& text, bool end_of_day, int64_t* out) {
+    if (text.size() == 10) {
+        return parse_iso_time(text + (end_of_day ? "T23:59:59Z" : "T00:00:00Z"), out);
+    }
+    return parse_iso_time(text, out);
+}
+
+static int run_time_query(const std::string& command, int argc, char* argv[]) {
+    int64_t from = INT64_MIN, to = INT64_MAX, width = 0;
+    int first_time = 2;
+    if (command == "histogram") {
+        std::string unit = argc > 2 ? argv[2] : "";
+        width = unit == "minute" ? BUCKET_MINUTE : unit == "hour" ? BUCKET_HOUR : unit == "day" ? BUCKET_DAY : 0;
+        first_time = 3;
+        if (width == 0 || (argc != 3 && argc != 5)) {
+            usage(argv[0]);
+            return 1;
+        }
+    } else if (argc != 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (argc > first_time &&
+        (!parse_time_arg(argv[first_time], false, &from) || !parse_time_arg(argv[first_time + 1], true, &to))) {
+        std::cerr << "Invalid time (expected YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DD).\n";
+        return 1;
+    }
+
+    load_db();
+    if (command == "between") {
+        print_blocks_between(from, to);
+    } else {
+        print_time_histogram(from, to, width);
+    }
+    return 0;
+}
+
+static int run_chain_query(const std::string& command, int argc, char* argv[]) {
+    int depth = 0;
+    if (command == "ancestor" && argc == 4) {
+        try {
+            depth = std::stoi(argv[3]);
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid number.\n";
+            return 1;
+        }
+    } else if (!(command == "common" && argc == 4) && !((command == "chain" || command == "validate") && argc == 2)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    load_db();
+    if (command == "ancestor") {
+        print_ancestor(argv[2], depth);
+    } else if (command == "common") {
+        print_common_ancestor(argv[2], argv[3]);
+    } else if (command == "chain") {
+        print_chain_report();
+    } else {
+        print_validation_report();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "ancestor" || command == "common" || command == "chain" || command == "validate") {
+        return run_chain_query(command, argc, argv);
+    }
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (command == "between" || command == "histogram") {
+        return run_time_query(command, argc, argv);
+    }
+    int from = INT_MIN, to = INT_MAX, k = 0;
+    try {
+        if (command == "stats" && argc == 4) {
+            from = std::stoi(argv[2]);
+            to = std::stoi(argv[3]);
+        } else if (command == "top" && (argc == 3 || argc == 5)) {
+            k = std::stoi(argv[2]);
+            if (argc == 5) {
+                from = std::stoi(argv[3]);
+                to = std::stoi(argv[4]);
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid number.\n";
+        return 1;
+    }
+
+    load_db();
+    if (command == "stats") {
+        print_range_stats(from, to);
+    } else {
+        print_top_k(from, to, k);
+    }
+    return 0;
+}
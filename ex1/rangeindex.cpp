@@ -0,0 +1,160 @@
+#include "rangeindex.h"
+#include <algorithm>
+#include <numeric>
+#include <queue>
+
+std::string sum_to_string(TotalSum value) {
+    if (value == 0) return "0";
+    bool negative = value < 0;
+    unsigned __int128 v = negative ? -(unsigned __int128)value : (unsigned __int128)value;
+    std::string digits;
+    while (v > 0) {
+        digits += (char)('0' + (int)(v % 10));
+        v /= 10;
+    }
+    if (negative) digits += '-';
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+void RangeIndex::clear() {
+    order_.clear();
+    heights_.clear();
+    totals_.clear();
+    prefix_.clear();
+    levels_min_.clear();
+    levels_max_.clear();
+}
+
+size_t RangeIndex::better(size_t a, size_t b, bool want_max) const {
+    if (want_max) return totals_[b] > totals_[a] ? b : a;
+    return totals_[b] < totals_[a] ? b : a;
+}
+
+void RangeIndex::build(const BlockTable& table) {
+    clear();
+    size_t n = table.size();
+    const int32_t* heights = table.heights();
+    const int64_t* totals = table.totals();
+
+    order_.resize(n);
+    std::iota(order_.begin(), order_.end(), 0);
+    // Stable, so blocks at the same height (forks) keep their load order.
+    std::stable_sort(order_.begin(), order_.end(),
+                     [heights](uint32_t a, uint32_t b) { return heights[a] < heights[b]; });
+
+    heights_.resize(n);
+    totals_.resize(n);
+    prefix_.resize(n + 1);
+    prefix_[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        heights_[i] = heights[order_[i]];
+        totals_[i] = totals[order_[i]];
+        prefix_[i + 1] = prefix_[i] + totals_[i];
+    }
+
+    size_t chunks = (n + CHUNK - 1) / CHUNK;
+    if (chunks == 0) return;
+    levels_min_.emplace_back(chunks);
+    levels_max_.emplace_back(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t lo = c * CHUNK, hi = std::min(n, lo + CHUNK);
+        size_t mn = lo, mx = lo;
+        for (size_t i = lo + 1; i < hi; ++i) {
+            mn = better(mn, i, false);
+            mx = better(mx, i, true);
+        }
+        levels_min_[0][c] = (uint32_t)mn;
+        levels_max_[0][c] = (uint32_t)mx;
+    }
+    for (size_t span = 2; span <= chunks; span *= 2) {
+        const auto& prev_min = levels_min_.back();
+        const auto& prev_max = levels_max_.back();
+        size_t count = chunks - span + 1;
+        std::vector<uint32_t> next_min(count), next_max(count);
+        for (size_t c = 0; c < count; ++c) {
+            next_min[c] = (uint32_t)better(prev_min[c], prev_min[c + span / 2], false);
+            next_max[c] = (uint32_t)better(prev_max[c], prev_max[c + span / 2], true);
+        }
+        levels_min_.push_back(std::move(next_min));
+        levels_max_.push_back(std::move(next_max));
+    }
+}
+
+void RangeIndex::locate(int from, int to, size_t* first, size_t* last) const {
+    *first = std::lower_bound(heights_.begin(), heights_.end(), from) - heights_.begin();
+    *last = std::upper_bound(heights_.begin(), heights_.end(), to) - heights_.begin();
+    if (*last < *first) *last = *first;
+}
+
+void RangeIndex::rows(int from, int to, const uint32_t** begin, const uint32_t** end) const {
+    size_t first, last;
+    locate(from, to, &first, &last);
+    *begin = order_.data() + first;
+    *end = order_.data() + last;
+}
+
+size_t RangeIndex::arg_extreme(size_t first, size_t last, bool want_max) const {
+    size_t best = first;
+    size_t first_chunk = (first + CHUNK - 1) / CHUNK;  // first whole chunk
+    size_t end_chunk = last / CHUNK;                   // one past the last whole chunk
+    if (first_chunk >= end_chunk) {
+        for (size_t i = first + 1; i < last; ++i) best = better(best, i, want_max);
+        return best;
+    }
+
+    for (size_t i = first + 1; i < first_chunk * CHUNK; ++i) best = better(best, i, want_max);
+    const auto& levels = want_max ? levels_max_ : levels_min_;
+    size_t span = end_chunk - first_chunk;
+    size_t k = 63 - __builtin_clzll(span);
+    best = better(best, levels[k][first_chunk], want_max);
+    best = better(best, levels[k][end_chunk - ((size_t)1 << k)], want_max);
+    for (size_t i = end_chunk * CHUNK; i < last; ++i) best = better(best, i, want_max);
+    return best;
+}
+
+bool RangeIndex::stats(int from, int to, RangeStats* out) const {
+    *out = RangeStats();
+    size_t first, last;
+    locate(from, to, &first, &last);
+    if (first == last) return false;
+
+    size_t mn = arg_extreme(first, last, false);
+    size_t mx = arg_extreme(first, last, true);
+    out->count = last - first;
+    out->sum = prefix_[last] - prefix_[first];
+    out->min = totals_[mn];
+    out->max = totals_[mx];
+    out->min_row = order_[mn];
+    out->max_row = order_[mx];
+    return true;
+}
+
+std::vector<size_t> RangeIndex::top_k(int from, int to, size_t k) const {
+    size_t first, last;
+    locate(from, to, &first, &last);
+    k = std::min(k, last - first);
+    if (k == 0) return {};
+
+    // Heap of the best k seen so far with the weakest on top. A block ranks
+    // higher with a larger total, or an equal total at a lower height.
+    auto ranks_higher = [this](size_t a, size_t b) {
+        return totals_[a] != totals_[b] ? totals_[a] > totals_[b] : a < b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(ranks_higher)> heap(ranks_higher);
+    for (size_t i = first; i < last; ++i) {
+        if (heap.size() < k) {
+            heap.push(i);
+        } else if (ranks_higher(i, heap.top())) {
+            heap.pop();
+            heap.push(i);
+        }
+    }
+
+    std::vector<size_t> rows(heap.size());
+    for (size_t j = rows.size(); j-- > 0;) {
+        rows[j] = order_[heap.top()];
+        heap.pop();
+    }
+    return rows;
+}
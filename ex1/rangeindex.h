@@ -0,0 +1,72 @@
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "chain.h"
+
+// Aggregates over the `total` column for height ranges.
+//
+// The chain is kept in load order (tip first for info.txt, refreshed blocks
+// at the end), so the index keeps its own copy of (height, total) sorted by
+// height. A height range is then a contiguous run found by binary search,
+// and over that run:
+//   - sum/avg come from prefix sums in O(1),
+//   - min/max come from a sparse table over 64-block chunks (O(1) for the
+//     whole chunks plus a scan of at most two partial chunks),
+//   - top-K is a bounded heap over the run, O(m log K).
+// Building is O(n log n) for the sort; the sparse table is n/64 * log(n/64)
+// entries, so it stays small next to the chain itself.
+
+// Sums can exceed int64 (heights x satoshis), so they are kept in 128 bits.
+typedef __int128 TotalSum;
+
+std::string sum_to_string(TotalSum value);
+
+struct RangeStats {
+    size_t count = 0;
+    TotalSum sum = 0;
+    int64_t min = 0;
+    int64_t max = 0;
+    size_t min_row = 0;   // table row holding min (first one on ties)
+    size_t max_row = 0;
+    double avg() const { return count ? (double)sum / (double)count : 0.0; }
+};
+
+class RangeIndex {
+public:
+    void clear();
+    void build(const BlockTable& table);
+    size_t size() const { return order_.size(); }
+
+    // Blocks with from <= height <= to. Returns false if there are none.
+    bool stats(int from, int to, RangeStats* out) const;
+
+    // Table rows of the k blocks in [from, to] with the largest total,
+    // largest first (lower height first on ties).
+    std::vector<size_t> top_k(int from, int to, size_t k) const;
+    // Table rows of the blocks in [from, to] in height order, as a span
+    // into the index: [*begin, *end), empty if there are none.
+    void rows(int from, int to, const uint32_t** begin, const uint32_t** end) const;
+
+private:
+    static const size_t CHUNK = 64;
+
+    // Positions [first, last) in sorted order for the height range.
+    void locate(int from, int to, size_t* first, size_t* last) const;
+    // Position of the min (or max) total in [first, last), last > first.
+    size_t arg_extreme(size_t first, size_t last, bool want_max) const;
+    size_t better(size_t a, size_t b, bool want_max) const;
+
+    std::vector<uint32_t> order_;    // table rows sorted by height
+    std::vector<int32_t> heights_;   // heights in that order
+    std::vector<int64_t> totals_;    // totals in that order
+    std::vector<TotalSum> prefix_;   // prefix_[i] = totals_[0] + ... + totals_[i-1]
+    // levels_min_[k][c]: position of the min over chunks c .. c + 2^k - 1.
+    std::vector<std::vector<uint32_t>> levels_min_;
+    std::vector<std::vector<uint32_t>> levels_max_;
+};
+
+#endif // RANGEINDEX_H
@@ -0,0 +1,148 @@
+#include "refresh.h"
+#include "fetcher.h"
+#include "json.h"
+#include <iostream>
+#include <cstdlib>
+#include <unordered_map>
+
+#define DEFAULT_API_URL "https://api.blockcypher.com/v1/btc/main"
+#define DEFAULT_MAX_BLOCKS 1000
+#define DEFAULT_CONNECTIONS 8
+#define MAX_CONNECTIONS 64
+#define DEFAULT_MAX_RETRIES 4
+
+RefreshOptions default_refresh_options() {
+    RefreshOptions options;
+    const char* url = getenv("BLOCKCYPHER_URL");
+    const char* token = getenv("BLOCKCYPHER_TOKEN");
+    options.base_url = url && *url ? url : DEFAULT_API_URL;
+    options.token = token ? token : "";
+    options.max_blocks = DEFAULT_MAX_BLOCKS;
+    options.connections = DEFAULT_CONNECTIONS;
+    options.max_retries = DEFAULT_MAX_RETRIES;
+    const char* connections = getenv("BLOCKCYPHER_CONNECTIONS");
+    if (connections && *connections) {
+        int n = atoi(connections);
+        options.connections = n < 1 ? 1 : (n > MAX_CONNECTIONS ? MAX_CONNECTIONS : n);
+    }
+    return options;
+}
+
+// Reads the one block document in `doc` with parse_json_blocks(), the
+// fields in `fields` only.
+static bool single_block(const std::string& doc, uint32_t fields, BlockTable* table) {
+    ParseReport report;
+    parse_json_blocks(doc, fields, *table, &report);
+    return table->size() == 1 && report.skipped == 0 && table->height(0) >= 0;
+}
+
+bool block_from_json(const std::string& doc, Block* out) {
+    BlockTable table;
+    if (!single_block(doc, FIELDS_ALL, &table)) return false;
+    *out = table.block(0);
+    return true;
+}
+
+std::string api_path(const Url& base, const RefreshOptions& options, const std::string& suffix) {
+    std::string path = base.path;
+    if (!path.empty() && path.back() == '/') path.pop_back();
+    path += suffix;
+    if (!options.token.empty()) path += "?token=" + options.token;
+    return path;
+}
+
+// GETs base.path + suffix and checks for a 200 response.
+static bool api_get(HttpConnection& conn, const Url& base, const RefreshOptions& options,
+                    const std::string& suffix, std::string* body) {
+    std::string path = api_path(base, options, suffix);
+    std::string problem;
+    FetchStats stats;
+    if (!get_with_retry(conn, base, path, options, 0, body, &problem, &stats)) {
+        std::cerr << "Refresh: " << path << ": " << problem << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Fetches the heights (lowest, tip] in parallel, keyed by block hash.
+static void prefetch_heights(const RefreshOptions& options, int lowest, int tip,
+                             std::unordered_map<std::string, Block>* cache) {
+    std::vector<std::string> ids;
+    for (int h = tip; h > lowest; --h) {
+        ids.push_back(std::to_string(h));
+    }
+    std::vector<Block> blocks;
+    std::vector<bool> ok;
+    FetchStats stats;
+    fetch_blocks(options, ids, &blocks, &ok, &stats);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (ok[i]) (*cache)[blocks[i].hash] = blocks[i];
+    }
+    if (stats.failed > 0 || stats.retries > 0) {
+        std::cerr << "Refresh: " << stats.requests << " requests, " << stats.retries
+                  << " retried, " << stats.failed << " failed" << std::endl;
+    }
+}
+
+bool fetch_new_blocks(const RefreshOptions& options,
+                      const std::function<bool(const Hash32&)>& known,
+                      int known_height, std::vector<Block>* out) {
+    Url base;
+    if (!parse_url(options.base_url, &base)) {
+        std::cerr << "Refresh: bad API URL " << options.base_url << std::endl;
+        return false;
+    }
+
+    HttpConnection conn;  // One kept-alive connection for the whole walk
+    std::string body;
+    BlockTable root;  // The chain document: its tip's hash and height
+    if (!api_get(conn, base, options, "", &body)) {
+        return false;
+    }
+    if (!single_block(body, FIELD_HASH | FIELD_HEIGHT, &root)) {
+        std::cerr << "Refresh: unexpected chain document" << std::endl;
+        return false;
+    }
+    std::string tip = root.hash_hex(0);
+
+    // Heights only locate candidates; the walk below still follows
+    // prev_block, so a block that moved during a reorg is simply refetched.
+    std::unordered_map<std::string, Block> prefetched;
+    if (options.connections > 1) {
+        int top = root.height(0);
+        int lowest = known_height;
+        if (lowest < top - options.max_blocks) lowest = top - options.max_blocks;
+        if (top - lowest > 1) {
+            prefetch_heights(options, lowest, top, &prefetched);
+        }
+    }
+
+    std::string next = tip;
+    while ((int)out->size() < options.max_blocks) {
+        Hash32 key;
+        if (!from_hex(next, key.bytes, 32)) {
+            std::cerr << "Refresh: malformed block hash '" << next << "'" << std::endl;
+            return false;
+        }
+        if (known(key)) {
+            break;  // Reached the part of the chain we already have
+        }
+
+        Block b;
+        auto hit = prefetched.find(next);
+        if (hit != prefetched.end()) {
+            b = hit->second;
+        } else {
+            if (!api_get(conn, base, options, "/blocks/" + next, &body)) {
+                return false;
+            }
+            if (!block_from_json(body, &b)) {
+                std::cerr << "Refresh: unexpected block document for " << next << std::endl;
+                return false;
+            }
+        }
+        out->push_back(b);
+        next = b.prev_block;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "chain.h"
+#include "http.h"
+
+// Incremental refresh against the BlockCypher REST API.
+//
+// The API root (default https://api.blockcypher.com/v1/btc/main) can be
+// pointed at a local stand-in server with BLOCKCYPHER_URL, e.g.
+//   BLOCKCYPHER_URL=http://127.0.0.1:8080/v1/btc/main ./ex4.out
+// BLOCKCYPHER_TOKEN, if set, is appended as ?token=... to every request.
+// BLOCKCYPHER_CONNECTIONS sets how many blocks are fetched in parallel
+// (default 8; 1 walks the chain one request at a time).
+
+struct RefreshOptions {
+    std::string base_url;
+    std::string token;
+    int max_blocks;     // upper bound on blocks fetched in one refresh
+    int connections;    // parallel keep-alive connections (requests in flight)
+    int max_retries;    // per request, on network errors, 429 and 5xx
+};
+
+// Options from the environment, with the defaults above.
+RefreshOptions default_refresh_options();
+
+// Walks back from the current tip through prev_block until it reaches a
+// block for which `known` returns true (or max_blocks were fetched).
+// With more than one connection, the heights between `known_height` (the
+// highest height already loaded, -1 if none) and the tip are first fetched
+// in parallel; the walk then only requests blocks that prefetch missed,
+// e.g. after a reorg. New blocks are returned newest first. Returns false
+// on a network or API error; blocks fetched before the error are still
+// returned.
+bool fetch_new_blocks(const RefreshOptions& options,
+                      const std::function<bool(const Hash32&)>& known,
+                      int known_height, std::vector<Block>* out);
+
+// Builds the request path for `suffix` under the API root, adding the token.
+std::string api_path(const Url& base, const RefreshOptions& options, const std::string& suffix);
+
+// Fills `out` from a BlockCypher block document, read by parse_json_blocks()
+// (json.h) with every field. False unless `doc` is one well-formed block
+// with a height of at least 0.
+bool block_from_json(const std::string& doc, Block* out);
+
+#endif // REFRESH_H
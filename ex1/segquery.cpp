@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <sys/stat.h>
+#include "segstore.h"
+
+// Lookups against the segmented store (info.seg, see txt2db.out --segments)
+// without loading the chain: only the segments a query touches are decoded,
+// and at most --cache-mb of them are kept.
+//   ./segquery.out [--file <info.seg>] [--cache-mb <n>] height <h> | hash <hash> | stats <from> <to> | info
+// Without a query, reads query lines ("height 850000", ...) from stdin and
+// reports the cache counters at the end on stderr.
+
+static void usage(const char* program) {
+    std::cout << "Usage: " << program << " [--file <info.seg>] [--cache-mb <n>] "
+              << "height <h> | hash <hash> | stats <from> <to> | info\n";
+}
+
+static void print_block(const BlockTable& segment, size_t i) {
+    std::cout << "hash: " << segment.hash_hex(i) << std::endl;
+    std::cout << "height: " << segment.height(i) << std::endl;
+    std::cout << "total: " << segment.total(i) << std::endl;
+    std::cout << "time: " << segment.time_iso(i) << std::endl;
+    std::cout << "relayed_by: " << segment.relayed_by(i) << std::endl;
+    std::cout << "prev_block: " << segment.prev_block_hex(i) << std::endl;
+}
+
+static void print_info(const SegmentStore& store) {
+    std::cout << "blocks: " << store.size() << std::endl;
+    std::cout << "segments: " << store.segment_count() << " of " << store.segment_blocks() << " heights"
+              << std::endl;
+    if (store.segment_count() > 0) {
+        std::cout << "heights: " << store.segment_info(0).min_height << " - "
+                  << store.segment_info(store.segment_count() - 1).max_height << std::endl;
+    }
+}
+
+// Runs one query; returns false if it was malformed.
+static bool run_query(SegmentStore& store, const std::string& command, const std::string& a, const std::string& b) {
+    SegmentPtr segment;
+    size_t row;
+    if (command == "height" && !a.empty()) {
+        if (store.find_height(atoi(a.c_str()), &segment, &row)) print_block(*segment, row);
+        else std::cout << "Block with height '" << a << "' not found." << std::endl;
+    } else if (command == "hash" && !a.empty()) {
+        Hash32 hash;
+        if (from_hex(a, hash.bytes, 32) && store.find_hash(hash, &segment, &row)) print_block(*segment, row);
+        else std::cout << "Block with hash '" << a << "' not found." << std::endl;
+    } else if (command == "stats" && !b.empty()) {
+        RangeStats stats;
+        if (!store.range_stats(atoi(a.c_str()), atoi(b.c_str()), &stats)) {
+            std::cout << "No blocks between heights " << a << " and " << b << "." << std::endl;
+            return true;
+        }
+        std::cout << "heights: " << a << " - " << b << std::endl;
+        std::cout << "blocks: " << stats.count << std::endl;
+        std::cout << "sum: " << sum_to_string(stats.sum) << std::endl;
+        std::cout << "min: " << stats.min << std::endl;
+        std::cout << "max: " << stats.max << std::endl;
+        std::cout << std::fixed << std::setprecision(2) << "avg: " << stats.avg() << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    } else if (command == "info") {
+        print_info(store);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = SEGSTORE_FILE;
+    size_t cache_bytes = DEFAULT_SEGMENT_CACHE_BYTES;
+    int arg = 1;
+    for (; arg + 1 < argc; arg += 2) {
+        std::string option = argv[arg];
+        if (option == "--file") path = argv[arg + 1];
+        else if (option == "--cache-mb") cache_bytes = (size_t)atol(argv[arg + 1]) << 20;
+        else break;
+    }
+
+    SegmentStore store;
+    if (!store.open(path, cache_bytes)) {
+        std::cerr << "Failed to open " << path << " (create it with txt2db.out --segments <heights>)" << std::endl;
+        return 1;
+    }
+    // refresh_data() rewrites info.seg, but info.txt may have changed otherwise.
+    struct stat seg, txt;
+    if (path == SEGSTORE_FILE && stat(path.c_str(), &seg) == 0 && stat("info.txt", &txt) == 0 &&
+        (txt.st_mtim.tv_sec > seg.st_mtim.tv_sec ||
+         (txt.st_mtim.tv_sec == seg.st_mtim.tv_sec && txt.st_mtim.tv_nsec > seg.st_mtim.tv_nsec))) {
+        std::cerr << path << " is older than info.txt; re-run txt2db.out --segments to include newer blocks"
+                  << std::endl;
+    }
+
+    if (arg < argc) {
+        std::string command = argv[arg];
+        std::string a = arg + 1 < argc ? argv[arg + 1] : "";
+        std::string b = arg + 2 < argc ? argv[arg + 2] : "";
+        if (arg + 3 < argc || !run_query(store, command, a, b)) {
+            usage(argv[0]);
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream words(line);
+        std::string command, a, b;
+        words >> command >> a >> b;
+        if (command.empty()) continue;
+        if (!run_query(store, command, a, b)) {
+            std::cout << "Unknown query '" << line << "'." << std::endl;
+        }
+    }
+    SegmentCacheStats stats = store.cache_stats();
+    std::cerr << "cache: " << stats.hits << " hits, " << stats.misses << " segments decoded, " << stats.evictions
+              << " evicted, " << stats.segments << " cached (" << (stats.bytes >> 10) << " of "
+              << (stats.limit >> 10) << " KB)";
+    if (stats.corrupt > 0) std::cerr << ", " << stats.corrupt << " corrupt";
+    std::cerr << std::endl;
+    return 0;
+}
@@ -0,0 +1,540 @@
+#include "segstore.h"
+#include "blockstore.h"
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const uint32_t MAX_SEGMENT_BLOCKS = 65536;
+// What a decoded row costs in a BlockTable (see chain.h), for the cache limit.
+static const size_t DECODED_ROW_BYTES = 2 * sizeof(Hash32) + 3 * sizeof(int64_t) + 4 * sizeof(int32_t);
+
+namespace {
+
+uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char)(v | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+// Bounds-checked reading of an encoded segment; any overrun sets `bad`.
+struct Reader {
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    bool bad = false;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        bad = true;
+        return 0;
+    }
+    void skip_varints(size_t n) {
+        for (; n > 0 && p < end; ++p) {
+            if (!(*p & 0x80)) --n;
+        }
+        if (n > 0) bad = true;
+    }
+    const uint8_t* bytes(size_t n) {
+        if ((size_t)(end - p) < n) {
+            bad = true;
+            return nullptr;
+        }
+        const uint8_t* at = p;
+        p += n;
+        return at;
+    }
+};
+
+int64_t floor_div(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Encodes rows `order[first, last)` (in height order) as one segment blob.
+void encode_segment(const BlockTable& t, const std::vector<uint32_t>& order, size_t first, size_t last,
+                    std::string& out) {
+    size_t n = last - first;
+    out.clear();
+    put_varint(out, n);
+    int64_t prev = 0;
+    for (size_t k = first; k < last; ++k) {
+        put_varint(out, zigzag(t.height(order[k]) - prev));
+        prev = t.height(order[k]);
+    }
+    prev = 0;
+    for (size_t k = first; k < last; ++k) {
+        put_varint(out, zigzag(t.time(order[k]) - prev));
+        prev = t.time(order[k]);
+    }
+    for (size_t k = first; k < last; ++k) put_varint(out, zigzag(t.total(order[k])));
+    for (size_t k = first; k < last; ++k) put_varint(out, t.relayed_ids()[order[k]]);
+    for (size_t k = first; k < last; ++k) put_varint(out, zigzag(t.n_tx(order[k])));
+    for (size_t k = first; k < last; ++k) put_varint(out, zigzag(t.fee(order[k])));
+    for (size_t k = first; k < last; ++k) put_varint(out, zigzag(t.size_bytes(order[k])));
+
+    // Bit k: prev_block of row k is the hash of row k - 1 (not stored again).
+    std::string linked((n + 7) / 8, '\0');
+    for (size_t k = first + 1; k < last; ++k) {
+        if (memcmp(t.prev_block(order[k]).bytes, t.hash(order[k - 1]).bytes, 32) == 0) {
+            linked[(k - first) / 8] |= (char)(1 << ((k - first) % 8));
+        }
+    }
+    out += linked;
+    for (size_t k = first; k < last; ++k) {
+        out.append(reinterpret_cast<const char*>(t.hash(order[k]).bytes), 32);
+    }
+    for (size_t k = first; k < last; ++k) {
+        size_t bit = k - first;
+        if (!(linked[bit / 8] & (1 << (bit % 8)))) {
+            out.append(reinterpret_cast<const char*>(t.prev_block(order[k]).bytes), 32);
+        }
+    }
+}
+
+// The directory key: the hash's last 8 bytes, the ones HashIndex::probe_start
+// uses. The leading bytes are the proof-of-work zeros, the same for every block.
+void hash_dir_prefix(const Hash32& hash, uint8_t prefix[8]) {
+    memcpy(prefix, hash.bytes + 24, 8);
+}
+
+bool hash_entry_less(const HashEntry& a, const HashEntry& b) {
+    int c = memcmp(a.prefix, b.prefix, sizeof(a.prefix));
+    if (c != 0) return c < 0;
+    return a.segment != b.segment ? a.segment < b.segment : a.row < b.row;
+}
+
+// Writes `len` bytes and pads with zeros to the next 8-byte boundary,
+// updating the running checksum and file offset.
+void write_padded(std::ofstream& out, const void* data, size_t len, uint32_t* checksum, uint64_t* offset) {
+    static const char zeros[8] = {0};
+    size_t pad = (8 - len % 8) % 8;
+    out.write(static_cast<const char*>(data), len);
+    out.write(zeros, pad);
+    *checksum = crc32(*checksum, data, len);
+    *checksum = crc32(*checksum, zeros, pad);
+    *offset += len + pad;
+}
+
+} // namespace
+
+bool save_segments(const BlockTable& table, const std::string& path, uint32_t segment_blocks) {
+    if (segment_blocks < 1 || segment_blocks > MAX_SEGMENT_BLOCKS) {
+        std::cerr << "Segment size must be 1 - " << MAX_SEGMENT_BLOCKS << " heights" << std::endl;
+        return false;
+    }
+    size_t n = table.size();
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+    const int32_t* h = table.heights();
+    std::stable_sort(order.begin(), order.end(), [h](uint32_t a, uint32_t b) { return h[a] < h[b]; });
+
+    std::string pool;
+    for (size_t i = 0; i < table.relayed_dict().size(); ++i) {
+        pool += table.relayed_dict().get((uint32_t)i);
+        pool += '\0';
+    }
+
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create " << tmp_path << std::endl;
+        return false;
+    }
+
+    SegFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGSTORE_MAGIC, sizeof(header.magic));
+    header.version = SEGSTORE_VERSION;
+    header.segment_blocks = segment_blocks;
+    header.count = n;
+    header.pool_length = (uint32_t)pool.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<SegmentEntry> dir;
+    std::vector<HashEntry> hashes(n);
+    std::string blob;
+    uint64_t offset = sizeof(header);
+    for (size_t first = 0; first < n;) {
+        int64_t segment = floor_div(h[order[first]], segment_blocks);
+        size_t last = first + 1;
+        while (last < n && floor_div(h[order[last]], segment_blocks) == segment) ++last;
+
+        SegmentEntry e;
+        memset(&e, 0, sizeof(e));
+        encode_segment(table, order, first, last, blob);
+        e.offset = offset;
+        e.length = (uint32_t)blob.size();
+        e.checksum = crc32(0, blob.data(), blob.size());
+        e.count = (uint32_t)(last - first);
+        e.min_height = h[order[first]];
+        e.max_height = h[order[last - 1]];
+        e.total_min = e.total_max = table.total(order[first]);
+        for (size_t k = first; k < last; ++k) {
+            int64_t total = table.total(order[k]);
+            e.total_sum += total;
+            e.total_min = std::min(e.total_min, total);
+            e.total_max = std::max(e.total_max, total);
+            HashEntry& he = hashes[k];
+            hash_dir_prefix(table.hash(order[k]), he.prefix);
+            he.segment = (uint32_t)dir.size();
+            he.row = (uint32_t)(k - first);
+        }
+        dir.push_back(e);
+        out.write(blob.data(), blob.size());
+        offset += blob.size();
+        first = last;
+    }
+    std::sort(hashes.begin(), hashes.end(), hash_entry_less);
+
+    // Directory, pool and hash directory each start on an 8-byte boundary.
+    static const char zeros[8] = {0};
+    size_t pad = (8 - offset % 8) % 8;
+    out.write(zeros, pad);
+    offset += pad;
+    header.directory_offset = offset;
+    header.segment_count = (uint32_t)dir.size();
+    uint32_t checksum = 0;
+    write_padded(out, dir.data(), dir.size() * sizeof(SegmentEntry), &checksum, &offset);
+    write_padded(out, pool.data(), pool.size(), &checksum, &offset);
+    write_padded(out, hashes.data(), hashes.size() * sizeof(HashEntry), &checksum, &offset);
+
+    header.checksum = checksum;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write " << tmp_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << tmp_path << " to " << path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+SegmentStore::SegmentStore()
+    : map_(nullptr), map_len_(0), count_(0), segment_blocks_(0), hash_dir_(nullptr), hash_count_(0) {}
+
+SegmentStore::~SegmentStore() {
+    close();
+}
+
+// Maps the file and checks the header, the directory CRC and that the
+// segments are in bounds and in height order. Segments are only checked
+// (their own CRC) when decoded.
+bool SegmentStore::open(const std::string& path, size_t cache_bytes) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SegFileHeader)) {
+        ::close(fd);
+        std::cerr << path << ": too small to be a segment store" << std::endl;
+        return false;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Failed to mmap " << path << std::endl;
+        return false;
+    }
+
+    size_t len = st.st_size;
+    const char* base = static_cast<const char*>(map);
+    const SegFileHeader* header = static_cast<const SegFileHeader*>(map);
+    size_t dir_len = (size_t)header->segment_count * sizeof(SegmentEntry);
+    size_t pool_at = header->directory_offset + dir_len;
+    size_t hashes_at = (pool_at + header->pool_length + 7) / 8 * 8;
+    const char* error = nullptr;
+    if (memcmp(header->magic, SEGSTORE_MAGIC, sizeof(header->magic)) != 0) {
+        error = "bad magic";
+    } else if (header->version != SEGSTORE_VERSION) {
+        error = "unsupported segment store version (re-run txt2db.out --segments)";
+    } else if (header->segment_blocks < 1 || header->segment_blocks > MAX_SEGMENT_BLOCKS) {
+        error = "bad segment size";
+    } else if (header->directory_offset % 8 != 0 || header->directory_offset > len ||
+               header->count > len / sizeof(HashEntry) || hashes_at + header->count * sizeof(HashEntry) != len) {
+        error = "truncated directory";
+    } else if (crc32(0, base + header->directory_offset, len - header->directory_offset) != header->checksum) {
+        error = "directory checksum mismatch";
+    }
+
+    std::vector<SegmentEntry> dir;
+    if (!error) {
+        dir.resize(header->segment_count);
+        memcpy(dir.data(), base + header->directory_offset, dir_len);
+        uint64_t blocks = 0;
+        for (size_t k = 0; k < dir.size() && !error; ++k) {
+            const SegmentEntry& e = dir[k];
+            blocks += e.count;
+            if (e.offset < sizeof(SegFileHeader) || e.offset > header->directory_offset ||
+                e.length > header->directory_offset - e.offset) {
+                error = "segment out of bounds";
+            } else if (e.count == 0 || e.min_height > e.max_height ||
+                       (k > 0 && e.min_height <= dir[k - 1].max_height)) {
+                error = "segments out of height order";
+            }
+        }
+        if (!error && blocks != header->count) {
+            error = "segment counts do not match block count";
+        }
+    }
+    if (error) {
+        std::cerr << path << ": " << error << std::endl;
+        munmap(map, len);
+        return false;
+    }
+
+    const char* pool = base + pool_at;
+    for (size_t pos = 0; pos < header->pool_length;) {
+        size_t n = strnlen(pool + pos, header->pool_length - pos);
+        pool_.emplace_back(pool + pos, n);
+        pos += n + 1;
+    }
+    map_ = map;
+    map_len_ = len;
+    count_ = header->count;
+    segment_blocks_ = header->segment_blocks;
+    segments_.swap(dir);
+    hash_dir_ = reinterpret_cast<const HashEntry*>(base + hashes_at);
+    hash_count_ = header->count;
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    stats_ = SegmentCacheStats();
+    stats_.limit = cache_bytes;
+    return true;
+}
+
+void SegmentStore::close() {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        lru_.clear();
+        entries_.clear();
+        stats_ = SegmentCacheStats();
+    }
+    if (map_) {
+        munmap(map_, map_len_);
+    }
+    map_ = nullptr;
+    map_len_ = 0;
+    count_ = 0;
+    segment_blocks_ = 0;
+    segments_.clear();
+    pool_.clear();
+    hash_dir_ = nullptr;
+    hash_count_ = 0;
+}
+
+bool SegmentStore::decode(size_t k, BlockTable* out) const {
+    const SegmentEntry& e = segments_[k];
+    const uint8_t* blob = static_cast<const uint8_t*>(map_) + e.offset;
+    if (crc32(0, blob, e.length) != e.checksum) return false;
+
+    Reader in{blob, blob + e.length};
+    size_t n = in.varint();
+    if (n != e.count) return false;
+    // One cursor per varint column (heights, times, totals, relayed_by,
+    // n_tx, fees, size), so rows are decoded in one pass without
+    // intermediate arrays.
+    Reader cols[7];
+    for (Reader& col : cols) {
+        col = Reader{in.p, in.end};
+        in.skip_varints(n);
+        col.end = in.p;
+    }
+    const uint8_t* linked = in.bytes((n + 7) / 8);
+    const uint8_t* hashes = in.bytes(n * 32);
+    if (in.bad) return false;
+
+    static const std::string unknown;
+    out->clear();
+    out->reserve(n);
+    Hash32 hash, prev_block;
+    int64_t height = 0, time = 0;
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(hash.bytes, hashes + 32 * i, 32);
+        if (i > 0 && (linked[i / 8] & (1 << (i % 8)))) {
+            memcpy(prev_block.bytes, hashes + 32 * (i - 1), 32);
+        } else {
+            const uint8_t* raw = in.bytes(32);
+            if (!raw) return false;
+            memcpy(prev_block.bytes, raw, 32);
+        }
+        height += unzigzag(cols[0].varint());
+        time += unzigzag(cols[1].varint());
+        int64_t total = unzigzag(cols[2].varint());
+        uint64_t relayed = cols[3].varint();
+        int64_t n_tx = unzigzag(cols[4].varint());
+        int64_t fees = unzigzag(cols[5].varint());
+        int64_t size = unzigzag(cols[6].varint());
+        const std::string& relayed_by = relayed < pool_.size() ? pool_[relayed] : unknown;
+        out->append(hash, (int)height, total, time, relayed_by, prev_block, (int)n_tx, fees, (int)size);
+    }
+    return in.p == in.end;
+}
+
+void SegmentStore::evict_locked() {
+    // The most recent segment always stays, even if it alone is over the limit.
+    while (stats_.bytes > stats_.limit && lru_.size() > 1) {
+        auto it = entries_.find(lru_.back());
+        stats_.bytes -= it->second.bytes;
+        entries_.erase(it);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+// Decoding happens outside the lock, so threads missing different segments
+// decode in parallel; if two decode the same one, the first insert wins.
+SegmentPtr SegmentStore::segment(size_t k) {
+    if (k >= segments_.size()) return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = entries_.find(k);
+        if (it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            ++stats_.hits;
+            return it->second.segment;
+        }
+    }
+
+    std::shared_ptr<BlockTable> table(new BlockTable());
+    bool ok = decode(k, table.get());
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (!ok) {
+        ++stats_.corrupt;
+        std::cerr << "Segment store: segment with heights " << segments_[k].min_height << " - "
+                  << segments_[k].max_height << " is corrupt" << std::endl;
+        return nullptr;
+    }
+    ++stats_.misses;
+    auto it = entries_.find(k);
+    if (it != entries_.end()) {
+        return it->second.segment;
+    }
+    lru_.push_front(k);
+    CacheEntry entry{table, table->size() * DECODED_ROW_BYTES + sizeof(BlockTable), lru_.begin()};
+    stats_.bytes += entry.bytes;
+    entries_.emplace(k, entry);
+    evict_locked();
+    return table;
+}
+
+void SegmentStore::overlapping(int from, int to, size_t* first, size_t* last) const {
+    *first = std::partition_point(segments_.begin(), segments_.end(),
+                                  [from](const SegmentEntry& e) { return e.max_height < from; }) -
+             segments_.begin();
+    *last = std::partition_point(segments_.begin() + *first, segments_.end(),
+                                 [to](const SegmentEntry& e) { return e.min_height <= to; }) -
+            segments_.begin();
+}
+
+bool SegmentStore::find_height(int height, SegmentPtr* seg, size_t* row) {
+    size_t first, last;
+    overlapping(height, height, &first, &last);
+    if (first == last) return false;
+    SegmentPtr s = segment(first);
+    if (!s) return false;
+    const int32_t* h = s->heights();
+    const int32_t* it = std::lower_bound(h, h + s->size(), height);
+    if (it == h + s->size() || *it != height) return false;
+    *seg = s;
+    *row = it - h;
+    return true;
+}
+
+bool SegmentStore::find_hash(const Hash32& hash, SegmentPtr* seg, size_t* row) {
+    HashEntry key;
+    hash_dir_prefix(hash, key.prefix);
+    key.segment = 0;
+    key.row = 0;
+    const HashEntry* end = hash_dir_ + hash_count_;
+    for (const HashEntry* it = std::lower_bound(hash_dir_, end, key, hash_entry_less);
+         it != end && memcmp(it->prefix, key.prefix, sizeof(key.prefix)) == 0; ++it) {
+        SegmentPtr s = segment(it->segment);
+        if (s && it->row < s->size() && memcmp(s->hash(it->row).bytes, hash.bytes, 32) == 0) {
+            *seg = s;
+            *row = it->row;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SegmentStore::range_stats(int from, int to, RangeStats* out) {
+    *out = RangeStats();
+    size_t first, last;
+    overlapping(from, to, &first, &last);
+    bool any = false;
+    auto add = [out, &any](int64_t total) {
+        if (!any || total < out->min) out->min = total;
+        if (!any || total > out->max) out->max = total;
+        any = true;
+    };
+    for (size_t k = first; k < last; ++k) {
+        const SegmentEntry& e = segments_[k];
+        if (e.min_height >= from && e.max_height <= to) {
+            add(e.total_min);
+            add(e.total_max);
+            out->count += e.count;
+            out->sum += e.total_sum;
+            continue;
+        }
+        SegmentPtr s = segment(k);
+        if (!s) continue;
+        for (size_t i = 0; i < s->size(); ++i) {
+            if (s->height(i) < from || s->height(i) > to) continue;
+            add(s->total(i));
+            ++out->count;
+            out->sum += s->total(i);
+        }
+    }
+    return out->count > 0;
+}
+
+size_t SegmentStore::verify() const {
+    size_t bad = 0;
+    BlockTable table;
+    for (size_t k = 0; k < segments_.size(); ++k) {
+        if (!decode(k, &table)) ++bad;
+    }
+    return bad;
+}
+
+void SegmentStore::set_cache_limit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    stats_.limit = bytes;
+    evict_locked();
+}
+
+SegmentCacheStats SegmentStore::cache_stats() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    SegmentCacheStats s = stats_;
+    s.segments = entries_.size();
+    return s;
+}
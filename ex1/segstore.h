@@ -0,0 +1,172 @@
+#ifndef SEGSTORE_H
+#define SEGSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "chain.h"
+#include "rangeindex.h"
+
+// Segmented, compressed block store (info.seg), for chains too long to keep
+// decoded in memory.
+//
+// Blocks are grouped by height into segments of `segment_blocks` heights
+// (heights with the same floor(height / segment_blocks)), stored in height
+// order and encoded column by column:
+//   - heights and times: zigzag varint deltas from the previous block,
+//   - totals, n_tx, fees, size: zigzag varints (-1 takes one byte),
+//   - relayed_by: varint ids into one dictionary for the whole file,
+//   - hashes: raw 32 bytes; prev_block only where it isn't the hash of the
+//     block before it (a bitmap says which), so a linked run costs nothing.
+// Each segment has its own CRC-32, checked whenever it is decoded.
+//
+// Layout: SegFileHeader, the segment blobs, then the SegmentEntry directory,
+// the relayed_by pool (NUL separated, in id order) and a hash directory of
+// HashEntry sorted by hash, so a hash lookup decodes one segment instead of
+// scanning all of them. The header CRC covers everything after the blobs.
+// All integers are stored in host (little-endian) byte order.
+
+#define SEGSTORE_MAGIC "BLKSEGS1"
+#define SEGSTORE_VERSION 2
+#define SEGSTORE_FILE "info.seg"
+// 2016 heights per segment: one difficulty period, about 2 weeks of blocks.
+#define DEFAULT_SEGMENT_BLOCKS 2016
+// Decoded segments kept by default: 64 MB, about 300 segments of 2016 blocks.
+#define DEFAULT_SEGMENT_CACHE_BYTES (64u << 20)
+
+struct SegFileHeader {
+    char magic[8];            // "BLKSEGS1" (not NUL terminated)
+    uint32_t version;         // SEGSTORE_VERSION
+    uint32_t segment_blocks;  // heights per segment
+    uint64_t count;           // number of blocks
+    uint64_t directory_offset;
+    uint32_t segment_count;
+    uint32_t pool_length;     // bytes of the relayed_by pool after the directory
+    uint32_t checksum;        // CRC-32 of everything from directory_offset on
+    uint32_t reserved;
+};
+
+struct SegmentEntry {
+    uint64_t offset;      // of the encoded blob, from the start of the file
+    uint32_t length;      // bytes
+    uint32_t checksum;    // CRC-32 of the blob
+    uint32_t count;       // blocks in the segment
+    int32_t min_height;
+    int32_t max_height;
+    uint32_t reserved;
+    // Aggregates of `total`, so a range query only decodes the segments
+    // at its two ends.
+    int64_t total_sum;
+    int64_t total_min;
+    int64_t total_max;
+};
+
+// A hash is looked up by its last 8 bytes (the first ones are the
+// proof-of-work zeros); the block found is then compared in full, so equal
+// prefixes just cost an extra segment.
+struct HashEntry {
+    uint8_t prefix[8];
+    uint32_t segment;     // position in the segment directory
+    uint32_t row;         // row within the decoded segment
+};
+
+static_assert(sizeof(SegFileHeader) == 48, "SegFileHeader must stay 48 bytes");
+static_assert(sizeof(SegmentEntry) == 56, "SegmentEntry must stay 56 bytes");
+static_assert(sizeof(HashEntry) == 16, "HashEntry must stay 16 bytes");
+
+// Writes `table` as a segmented store (temporary file renamed into place).
+// Rows with equal heights are all kept. segment_blocks is 1 - 65536, which
+// keeps a segment's total_sum within int64.
+bool save_segments(const BlockTable& table, const std::string& path,
+                   uint32_t segment_blocks = DEFAULT_SEGMENT_BLOCKS);
+
+// Cache counters since open().
+struct SegmentCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;      // segments decoded
+    uint64_t evictions = 0;
+    uint64_t corrupt = 0;     // segments whose checksum failed
+    size_t segments = 0;      // currently cached
+    size_t bytes = 0;         // their estimated size
+    size_t limit = 0;
+};
+
+// A decoded segment: its blocks in height order. Shared, so a segment
+// evicted from the cache stays valid for whoever still holds it.
+typedef std::shared_ptr<const BlockTable> SegmentPtr;
+
+// Read-only mmap of an info.seg file with an LRU cache of decoded segments.
+// Opening checks the header, the directory and its CRC but decodes nothing;
+// every lookup decodes (or finds cached) only the segments it touches.
+// All members are safe to call from several threads.
+class SegmentStore {
+public:
+    SegmentStore();
+    ~SegmentStore();
+
+    bool open(const std::string& path, size_t cache_bytes = DEFAULT_SEGMENT_CACHE_BYTES);
+    void close();
+    bool is_open() const { return map_ != nullptr; }
+    size_t size() const { return count_; }
+    size_t segment_count() const { return segments_.size(); }
+    uint32_t segment_blocks() const { return segment_blocks_; }
+    const SegmentEntry& segment_info(size_t k) const { return segments_[k]; }
+
+    // Segment k of the directory, decoded; null if its checksum fails.
+    SegmentPtr segment(size_t k);
+
+    // The block with this height / hash: `*seg` gets its segment and `*row`
+    // its row there. Returns false if there is none (or it is corrupt).
+    bool find_height(int height, SegmentPtr* seg, size_t* row);
+    bool find_hash(const Hash32& hash, SegmentPtr* seg, size_t* row);
+
+    // Aggregates of `total` over from <= height <= to. Segments inside the
+    // range are answered from the directory; only the (at most two) that
+    // stick out of it are decoded. min_row/max_row are not set.
+    bool range_stats(int from, int to, RangeStats* out);
+
+    // Decodes every segment (bypassing the cache) and checks its CRC.
+    // Returns the number of corrupt segments.
+    size_t verify() const;
+
+    // Changing the limit evicts right away if the cache is now over it.
+    void set_cache_limit(size_t bytes);
+    SegmentCacheStats cache_stats() const;
+
+private:
+    SegmentStore(const SegmentStore&);
+    SegmentStore& operator=(const SegmentStore&);
+
+    // Directory positions of the segments overlapping [from, to].
+    void overlapping(int from, int to, size_t* first, size_t* last) const;
+    bool decode(size_t k, BlockTable* out) const;
+    void evict_locked();
+
+    void* map_;
+    size_t map_len_;
+    size_t count_;
+    uint32_t segment_blocks_;
+    std::vector<SegmentEntry> segments_;  // in height order
+    std::vector<std::string> pool_;       // relayed_by strings by id
+    const HashEntry* hash_dir_;
+    size_t hash_count_;
+
+    // LRU: most recently used at the front of lru_; entries_ maps a
+    // directory position to its cached segment and its place in lru_.
+    struct CacheEntry {
+        SegmentPtr segment;
+        size_t bytes;
+        std::list<size_t>::iterator lru;
+    };
+    mutable std::mutex cache_mutex_;
+    std::list<size_t> lru_;
+    std::unordered_map<size_t, CacheEntry> entries_;
+    SegmentCacheStats stats_;
+};
+
+#endif // SEGSTORE_H
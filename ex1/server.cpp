@@ -0,0 +1,376 @@
+#include "server.h"
+#include "infra.h"
+#include "rangeindex.h"
+#include "snapshot.h"
+#include <cerrno>
+#include <csignal>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static const size_t MAX_WORDS = 5;
+// Per connection: requests read ahead of the answers, and answers queued
+// before the connection stops being read until the client catches up.
+static const size_t MAX_INPUT_BUFFER = 16 * MAX_REQUEST_LINE;
+static const size_t MAX_OUTPUT_BUFFER = 1 << 20;
+
+static int stop_fd = -1;
+// Set by a stop request that came before the eventfd existed.
+static volatile sig_atomic_t stop_requested = 0;
+
+void request_server_stop() {
+    stop_requested = 1;
+    if (stop_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(stop_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+// Splits on spaces/tabs; returns the number of words (at most MAX_WORDS + 1,
+// so callers can tell "too many").
+static size_t split_words(std::string_view line, std::string_view* words) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (count <= MAX_WORDS) {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) ++pos;
+        if (pos >= line.size()) break;
+        size_t end = pos;
+        while (end < line.size() && line[end] != ' ' && line[end] != '\t' && line[end] != '\r') ++end;
+        words[count++] = line.substr(pos, end - pos);
+        pos = end;
+    }
+    return count;
+}
+
+static bool to_int(std::string_view s, int* out) {
+    auto res = std::from_chars(s.data(), s.data() + s.size(), *out);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+static std::string block_response(const BlockTable& chain, size_t i) {
+    std::string out = "ok\t";
+    out += chain.hash_hex(i);
+    out += '\t';
+    out += std::to_string(chain.height(i));
+    out += '\t';
+    out += std::to_string(chain.total(i));
+    out += '\t';
+    out += chain.time_iso(i);
+    out += '\t';
+    out += chain.relayed_by(i);
+    out += '\t';
+    out += chain.prev_block_hex(i);
+    out += '\t';
+    out += std::to_string(chain.n_tx(i));
+    out += '\t';
+    out += std::to_string(chain.fee(i));
+    out += '\t';
+    out += std::to_string(chain.size_bytes(i));
+    return out;
+}
+
+std::string handle_request(const std::string& line) {
+    std::string_view words[MAX_WORDS + 1];
+    size_t count = split_words(line, words);
+    if (count == 0) return "err\tempty request";
+    std::string_view cmd = words[0];
+    size_t row;
+    // Held for the whole request, so a reload can't swap the chain between
+    // the lookup and the formatting.
+    std::shared_ptr<const ChainSnapshot> snap = chain_snapshot();
+    const BlockTable& chain = snap->table();
+
+    if (cmd == "h" && count == 2) {
+        Hash32 hash;
+        if (!from_hex(words[1], hash.bytes, sizeof(hash.bytes))) return "err\tbad hash";
+        return snap->find_hash(words[1], &row) ? block_response(chain, row) : "nf";
+    }
+    if (cmd == "n" && count == 2) {
+        int height;
+        if (!to_int(words[1], &height)) return "err\tbad height";
+        return snap->find_height(height, &row) ? block_response(chain, row) : "nf";
+    }
+    if (cmd == "r" && count == 3) {
+        int from, to;
+        if (!to_int(words[1], &from) || !to_int(words[2], &to)) return "err\tbad height";
+        RangeStats stats;
+        if (!snap->ranges().stats(from, to, &stats)) return "nf";
+        char avg[64];
+        snprintf(avg, sizeof(avg), "%.2f", stats.avg());
+        return "ok\t" + std::to_string(stats.count) + "\t" + sum_to_string(stats.sum) + "\t" +
+               std::to_string(stats.min) + "\t" + std::to_string(stats.max) + "\t" + avg;
+    }
+    if (cmd == "t" && (count == 2 || count == 4)) {
+        int k, from = INT_MIN, to = INT_MAX;
+        if (!to_int(words[1], &k) || k < 0) return "err\tbad k";
+        if (count == 4 && (!to_int(words[2], &from) || !to_int(words[3], &to))) return "err\tbad height";
+        std::vector<size_t> rows = snap->ranges().top_k(from, to, (size_t)k);
+        std::string out = "ok\t" + std::to_string(rows.size());
+        for (size_t i : rows) {
+            out += '\t';
+            out += std::to_string(chain.height(i));
+            out += ' ';
+            out += std::to_string(chain.total(i));
+            out += ' ';
+            out += chain.hash_hex(i);
+        }
+        return out;
+    }
+    if (cmd == "p" && count == 1) {
+        return "ok";
+    }
+    return "err\tunknown request (expected h, n, r, t or p)";
+}
+
+namespace {
+
+struct Connection {
+    int fd;
+    bool listener;
+    std::string in;        // bytes received but not yet answered
+    std::string out;       // answers not yet sent, from out_sent on
+    size_t out_sent = 0;
+    bool closing = false;  // no more requests; drop once out is sent
+};
+
+class Server {
+public:
+    Server() : epoll_fd_(-1), listener_{-1, true}, stopper_{-1, false} {}
+    ~Server() { shutdown(); }
+
+    bool start(const std::string& path);
+    void work();
+    void shutdown();
+
+private:
+    bool arm(Connection* c, int op);
+    void accept_all();
+    bool serve(Connection* c);   // false once the connection is done
+    void read_input(Connection* c);
+    void answer(Connection* c);
+    bool flush(Connection* c);
+    void drop(Connection* c);
+
+    int epoll_fd_;
+    Connection listener_;
+    Connection stopper_;
+    std::string path_;
+    std::mutex mutex_;                          // guards connections_
+    std::unordered_set<Connection*> connections_;
+};
+
+bool Server::arm(Connection* c, int op) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    // A connection with answers still queued waits for room to send them,
+    // not for more requests.
+    ev.events = !c->out.empty() ? EPOLLOUT : EPOLLIN | EPOLLRDHUP;
+    if (c != &stopper_) ev.events |= EPOLLONESHOT;
+    ev.data.ptr = c;
+    return epoll_ctl(epoll_fd_, op, c->fd, &ev) == 0;
+}
+
+bool Server::start(const std::string& path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    // A leftover socket file from a crashed server is removed; a live
+    // server on the same path is an error.
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        close(probe);
+        std::cerr << "Another server is already listening on " << path << std::endl;
+        return false;
+    }
+    if (probe >= 0) close(probe);
+    unlink(path.c_str());
+
+    listener_.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener_.fd < 0 || bind(listener_.fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listener_.fd, SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_ = path;
+
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stopper_.fd = stop_fd;
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (stop_fd < 0 || epoll_fd_ < 0 || !arm(&listener_, EPOLL_CTL_ADD) || !arm(&stopper_, EPOLL_CTL_ADD)) {
+        std::cerr << "Failed to set up epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (stop_requested) request_server_stop();  // a signal beat the eventfd
+    return true;
+}
+
+void Server::accept_all() {
+    for (;;) {
+        int fd = accept4(listener_.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) break;
+        Connection* c = new Connection{fd, false};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connections_.insert(c);
+        }
+        if (!arm(c, EPOLL_CTL_ADD)) drop(c);
+    }
+    arm(&listener_, EPOLL_CTL_MOD);
+}
+
+void Server::read_input(Connection* c) {
+    char buf[16384];
+    while (c->in.size() < MAX_INPUT_BUFFER) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c->in.append(buf, n);
+            if ((size_t)n < sizeof(buf)) break;
+        } else if (n == 0) {
+            c->closing = true;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->closing = true;
+            break;
+        }
+    }
+}
+
+// Queues the answers to the complete lines in c->in, in order, until the
+// output backlog is full.
+void Server::answer(Connection* c) {
+    size_t start = 0;
+    for (size_t nl; c->out.size() < MAX_OUTPUT_BUFFER && (nl = c->in.find('\n', start)) != std::string::npos;
+         start = nl + 1) {
+        c->out += handle_request(c->in.substr(start, nl - start));
+        c->out += '\n';
+    }
+    c->in.erase(0, start);
+    if (c->in.size() > MAX_REQUEST_LINE && c->in.find('\n') == std::string::npos) {
+        c->out += "err\trequest line too long\n";
+        c->in.clear();
+        c->closing = true;
+    }
+}
+
+// Sends what the socket takes without waiting; false if the client is gone.
+bool Server::flush(Connection* c) {
+    while (c->out_sent < c->out.size()) {
+        ssize_t n = send(c->fd, c->out.data() + c->out_sent, c->out.size() - c->out_sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->out_sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;  // the rest goes out on EPOLLOUT
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    c->out.clear();
+    c->out_sent = 0;
+    return true;
+}
+
+bool Server::serve(Connection* c) {
+    // Nothing is read while answers are queued, so a client that doesn't
+    // read its answers only holds a bounded buffer, never a thread.
+    for (;;) {
+        if (!flush(c)) return false;
+        if (!c->out.empty()) return true;
+        answer(c);
+        if (!c->out.empty()) continue;
+        if (c->closing) return false;
+        size_t pending = c->in.size();
+        read_input(c);
+        if (c->in.size() == pending && !c->closing) return true;  // wait for more
+    }
+}
+
+void Server::drop(Connection* c) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c->fd, nullptr);
+    close(c->fd);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.erase(c);
+    }
+    delete c;
+}
+
+void Server::work() {
+    for (;;) {
+        struct epoll_event ev;
+        int n = epoll_wait(epoll_fd_, &ev, 1, -1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        Connection* c = static_cast<Connection*>(ev.data.ptr);
+        if (c == &stopper_) {
+            break;  // Level-triggered, so every worker sees it
+        } else if (c == &listener_) {
+            accept_all();
+        } else if (serve(c)) {
+            arm(c, EPOLL_CTL_MOD);
+        } else {
+            drop(c);
+        }
+    }
+}
+
+void Server::shutdown() {
+    for (Connection* c : connections_) {
+        close(c->fd);
+        delete c;
+    }
+    connections_.clear();
+    if (listener_.fd >= 0) close(listener_.fd);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (stop_fd >= 0) close(stop_fd);
+    if (!path_.empty()) unlink(path_.c_str());
+    listener_.fd = epoll_fd_ = stop_fd = -1;
+    path_.clear();
+}
+
+} // namespace
+
+bool run_server(const std::string& socket_path, int threads) {
+    Server server;
+    if (!server.start(socket_path)) {
+        return false;
+    }
+
+    // Build the lazy index before the first client waits for it.
+    chain_snapshot()->ranges();
+
+    if (threads < 1) threads = 1;
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back([&server] { server.work(); });
+    }
+    server.work();
+    for (auto& t : pool) {
+        t.join();
+    }
+    return true;
+}
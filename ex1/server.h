@@ -0,0 +1,41 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+
+// Query server for the loaded chain over a Unix domain socket.
+//
+// Protocol: one request per line, one response per line, fields separated
+// by a tab. Clients may pipeline (send many requests before reading);
+// responses come back in request order.
+//
+//   h <hash>               ok <block fields>   or   nf
+//   n <height>             ok <block fields>   or   nf
+//   r <from> <to>          ok <count> <sum> <min> <max> <avg>   or   nf
+//   t <k> [<from> <to>]    ok <k'> then k' entries "<height> <total> <hash>"
+//   p                      ok                  (ping)
+//   anything else          err <message>
+//
+// Block fields: hash height total time relayed_by prev_block n_tx fees size.
+//
+// Connections are served by a fixed pool of threads sharing one epoll set
+// (EPOLLONESHOT, so a connection is handled by one thread at a time), so
+// many idle or slow clients don't tie up a thread each. Answers a client
+// isn't reading wait in its own buffer (sent on EPOLLOUT), and the client's
+// requests aren't read until they are gone.
+
+#define DEFAULT_SERVER_SOCKET "blockd.sock"
+#define MAX_REQUEST_LINE 4096
+
+// Serves until request_server_stop() is called. load_db() must have run.
+// Returns false if the socket can't be set up.
+bool run_server(const std::string& socket_path, int threads);
+
+// Async-signal-safe; makes run_server() return (at once if called before it).
+void request_server_stop();
+
+// Answers one request line (without the newline); used by the server and
+// handy for testing the protocol without a socket.
+std::string handle_request(const std::string& line);
+
+#endif // SERVER_H
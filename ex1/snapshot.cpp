@@ -0,0 +1,97 @@
+#include "snapshot.h"
+#include <atomic>
+#include <thread>
+
+static std::shared_ptr<const ChainSnapshot> current = std::make_shared<ChainSnapshot>();
+
+std::shared_ptr<const ChainSnapshot> chain_snapshot() {
+    return std::atomic_load(&current);
+}
+
+void publish_snapshot(std::shared_ptr<const ChainSnapshot> next) {
+    std::atomic_store(&current, std::move(next));
+}
+
+ChainSnapshot::ChainSnapshot() : height_indexed_(true), from_store_(false) {}
+
+ChainSnapshot::ChainSnapshot(BlockTable table, bool from_store, size_t skipped)
+    : table_(std::move(table)), from_store_(from_store) {
+    hash_index_.build(table_.hashes(), table_.size());
+    height_indexed_ = height_index_.build(table_.heights(), table_.size());
+    validate(skipped);
+}
+
+void ChainSnapshot::validate(size_t skipped) {
+    validation_.skipped = skipped;
+    validate_chain(table_, hash_index_, height_indexed_ ? &height_index_ : nullptr,
+                   (int)std::thread::hardware_concurrency(), &validation_);
+}
+
+std::shared_ptr<ChainSnapshot> ChainSnapshot::with_appended(const std::vector<Block>& blocks,
+                                                            std::vector<Block>* added) const {
+    std::shared_ptr<ChainSnapshot> next(new ChainSnapshot());
+    next->table_ = table_;
+    next->from_store_ = from_store_;
+    for (const Block& b : blocks) {
+        if (next->table_.append(b)) added->push_back(b);
+    }
+    // The indexes are extended rather than rebuilt; `extend` is given the
+    // new columns, so nothing points into this snapshot afterwards.
+    next->hash_index_ = hash_index_;
+    next->hash_index_.extend(next->table_.hashes(), next->table_.size());
+    next->height_index_ = height_index_;
+    next->height_indexed_ = height_indexed_ &&
+                            next->height_index_.extend(next->table_.heights(), table_.size(), next->table_.size());
+    next->validate(validation_.skipped);
+    return next;
+}
+
+bool ChainSnapshot::find_hash(std::string_view hex, size_t* row) const {
+    Hash32 key;
+    if (!from_hex(hex, key.bytes, sizeof(key.bytes))) {
+        return false;
+    }
+    uint32_t slot = hash_index_.find(key);
+    if (slot == NO_SLOT) {
+        return false;
+    }
+    *row = slot;
+    return true;
+}
+
+bool ChainSnapshot::find_height(int height, size_t* row) const {
+    uint32_t slot = NO_SLOT;
+    if (height_indexed_) {
+        slot = height_index_.find(height);
+    } else {
+        size_t count = table_.size();
+        for (size_t i = 0; i < count && slot == NO_SLOT; ++i) {
+            if (table_.height(i) == height) slot = (uint32_t)i;
+        }
+    }
+    if (slot == NO_SLOT) {
+        return false;
+    }
+    *row = slot;
+    return true;
+}
+
+const RangeIndex& ChainSnapshot::ranges() const {
+    std::call_once(range_once_, [this] { range_index_.build(table_); });
+    return range_index_;
+}
+
+const TimeIndex& ChainSnapshot::times() const {
+    std::call_once(time_once_, [this] { time_index_.build(table_); });
+    return time_index_;
+}
+
+const HashPrefixIndex& ChainSnapshot::prefixes() const {
+    std::call_once(prefix_once_, [this] { prefix_index_.build(table_.hashes(), table_.size()); });
+    return prefix_index_;
+}
+
+const ChainIndex& ChainSnapshot::links() const {
+    std::call_once(chain_once_, [this] { chain_index_.build(table_, hash_index_); });
+    return chain_index_;
+}
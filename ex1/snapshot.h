@@ -0,0 +1,78 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "chain.h"
+#include "blockindex.h"
+#include "rangeindex.h"
+#include "timeindex.h"
+#include "chainindex.h"
+#include "validate.h"
+
+// One immutable version of the loaded chain and everything derived from it.
+//
+// load_db() and refresh_data() build a complete new snapshot on the side and
+// publish it with one atomic pointer store; readers take a reference-counted
+// pointer to whatever is current and keep using it for as long as they hold
+// it (RCU style). A reader therefore never blocks on a reload and never sees
+// an empty or half-built chain, and a row number is only meaningful within
+// the snapshot it came from.
+//
+// The lazily built indexes are part of the snapshot too: the first query
+// that needs one builds it (std::call_once), later ones share it.
+class ChainSnapshot {
+public:
+    ChainSnapshot();  // empty chain
+    // Takes the table over, builds the hash/height indexes and validates it.
+    ChainSnapshot(BlockTable table, bool from_store, size_t skipped);
+
+    ChainSnapshot(const ChainSnapshot&) = delete;
+    ChainSnapshot& operator=(const ChainSnapshot&) = delete;
+
+    // A new snapshot with `blocks` appended; rows of this one keep their
+    // numbers. Copies the columns, since a published snapshot never changes.
+    // `added` gets the blocks that were well-formed.
+    std::shared_ptr<ChainSnapshot> with_appended(const std::vector<Block>& blocks,
+                                                 std::vector<Block>* added) const;
+
+    const BlockTable& table() const { return table_; }
+    size_t size() const { return table_.size(); }
+    bool loaded_from_store() const { return from_store_; }
+    const ValidationReport& validation() const { return validation_; }
+
+    bool find_hash(std::string_view hex, size_t* row) const;
+    bool contains(const Hash32& hash) const { return hash_index_.find(hash) != NO_SLOT; }
+    bool find_height(int height, size_t* row) const;
+
+    const RangeIndex& ranges() const;
+    const TimeIndex& times() const;
+    const HashPrefixIndex& prefixes() const;
+    const ChainIndex& links() const;
+
+private:
+    void validate(size_t skipped);
+
+    BlockTable table_;
+    HashIndex hash_index_;
+    HeightIndex height_index_;
+    bool height_indexed_;  // false if heights were too sparse to index
+    bool from_store_;      // true if the columns are mapped from info.db
+    ValidationReport validation_;
+
+    mutable std::once_flag range_once_, time_once_, prefix_once_, chain_once_;
+    mutable RangeIndex range_index_;
+    mutable TimeIndex time_index_;
+    mutable HashPrefixIndex prefix_index_;
+    mutable ChainIndex chain_index_;
+};
+
+// The current snapshot; never null (empty before the first load_db()).
+std::shared_ptr<const ChainSnapshot> chain_snapshot();
+// Makes `next` current. Readers holding the previous one are unaffected.
+void publish_snapshot(std::shared_ptr<const ChainSnapshot> next);
+
+#endif // SNAPSHOT_H
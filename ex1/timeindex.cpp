@@ -0,0 +1,89 @@
+#include "timeindex.h"
+#include <algorithm>
+#include <numeric>
+
+void TimeIndex::clear() {
+    order_.clear();
+    times_.clear();
+    prefix_.clear();
+}
+
+void TimeIndex::build(const BlockTable& table) {
+    clear();
+    size_t n = table.size();
+    const int64_t* times = table.times();
+    const int64_t* totals = table.totals();
+
+    order_.resize(n);
+    std::iota(order_.begin(), order_.end(), 0);
+    std::stable_sort(order_.begin(), order_.end(),
+                     [times](uint32_t a, uint32_t b) { return times[a] < times[b]; });
+
+    times_.resize(n);
+    prefix_.resize(n + 1);
+    prefix_[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        times_[i] = times[order_[i]];
+        prefix_[i + 1] = prefix_[i] + totals[order_[i]];
+    }
+}
+
+void TimeIndex::locate(int64_t from, int64_t to, size_t* first, size_t* last) const {
+    *first = std::lower_bound(times_.begin(), times_.end(), from) - times_.begin();
+    *last = std::upper_bound(times_.begin(), times_.end(), to) - times_.begin();
+    if (*last < *first) *last = *first;
+}
+
+std::vector<size_t> TimeIndex::range(int64_t from, int64_t to) const {
+    size_t first, last;
+    locate(from, to, &first, &last);
+    return std::vector<size_t>(order_.begin() + first, order_.begin() + last);
+}
+
+// Rounds down to a multiple of `width`, also for times before 1970.
+static int64_t floor_to(int64_t t, int64_t width) {
+    int64_t q = t / width;
+    if (t % width != 0 && t < 0) --q;
+    return q * width;
+}
+
+bool TimeIndex::histogram(int64_t from, int64_t to, int64_t width, TimeHistogram* out) const {
+    *out = TimeHistogram();
+    size_t first, last;
+    locate(from, to, &first, &last);
+    if (first == last || width <= 0) return false;
+
+    int64_t start = floor_to(times_[first], width);
+    int64_t end = floor_to(times_[last - 1], width);
+    size_t buckets = (size_t)((end - start) / width) + 1;
+    if (buckets > MAX_BUCKETS) return false;
+
+    out->start = start;
+    out->width = width;
+    out->blocks.resize(buckets);
+    out->totals.resize(buckets);
+
+    // Times are sorted, so each bucket is a contiguous run: find its end
+    // with a search starting where the previous one stopped, then take the
+    // count and sum from the positions and the prefix sums. No per-block
+    // work at all, and sparse buckets cost one short search each.
+    size_t pos = first;
+    for (size_t b = 0; b < buckets; ++b) {
+        int64_t edge = start + (int64_t)(b + 1) * width;  // first second of the next bucket
+        size_t stop = pos;
+        if (stop < last && times_[stop] < edge) {
+            // Gallop forward, then binary search inside the last step.
+            size_t step = 1;
+            while (stop + step < last && times_[stop + step] < edge) {
+                stop += step;
+                step *= 2;
+            }
+            stop = std::lower_bound(times_.begin() + stop, times_.begin() + std::min(last, stop + step), edge) -
+                   times_.begin();
+        }
+        out->blocks[b] = (uint32_t)(stop - pos);
+        out->totals[b] = prefix_[stop] - prefix_[pos];
+        pos = stop;
+    }
+    return true;
+}
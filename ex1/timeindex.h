@@ -0,0 +1,53 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "chain.h"
+#include "rangeindex.h"
+
+// Time-ordered view of the chain for "blocks mined between T1 and T2".
+//
+// Block times are already epoch seconds in the BlockTable; the index keeps
+// the rows sorted by time (block times are not monotonic in height), so a
+// time range is two binary searches. Prefix sums of `total` in the same
+// order make every histogram bucket O(1) once its edges are found.
+
+#define BUCKET_MINUTE 60
+#define BUCKET_HOUR 3600
+#define BUCKET_DAY 86400
+
+// Buckets are aligned to multiples of `width` since the epoch (UTC).
+struct TimeHistogram {
+    int64_t start = 0;              // epoch seconds of the first bucket
+    int64_t width = 0;              // seconds per bucket
+    std::vector<uint32_t> blocks;   // blocks per bucket
+    std::vector<TotalSum> totals;   // summed total per bucket
+};
+
+class TimeIndex {
+public:
+    void clear();
+    void build(const BlockTable& table);
+    size_t size() const { return order_.size(); }
+
+    // Table rows with from <= time <= to, oldest first.
+    std::vector<size_t> range(int64_t from, int64_t to) const;
+
+    // Histogram over blocks with from <= time <= to. Buckets run from the
+    // first to the last block in the range, empty ones included. Returns
+    // false if the range is empty or would need more than MAX_BUCKETS.
+    bool histogram(int64_t from, int64_t to, int64_t width, TimeHistogram* out) const;
+
+    static const size_t MAX_BUCKETS = 10000000;
+
+private:
+    void locate(int64_t from, int64_t to, size_t* first, size_t* last) const;
+
+    std::vector<uint32_t> order_;    // table rows sorted by time
+    std::vector<int64_t> times_;     // times in that order
+    std::vector<TotalSum> prefix_;   // prefix sums of total in that order
+};
+
+#endif // TIMEINDEX_H
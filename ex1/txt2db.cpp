@@ -0,0 +1,127 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "blockstore.h"
+#include "csvimport.h"
+#include "infra.h"
+#include "json.h"
+#include "segstore.h"
+
+// One-shot converter: info.txt -> info.db (binary, memory-mappable).
+// The input may also be BlockCypher JSON (a document, an array of them or
+// NDJSON); --fields picks which members to keep (default: all), or CSV
+// exported by ex3.out (the columns it has).
+// --segments <heights> writes the segmented, compressed info.seg instead
+// (see segstore.h).
+
+// Returns true if `path` starts with the segment store magic.
+static bool is_segment_store(const std::string& path) {
+    char magic[8];
+    std::ifstream file(path, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && memcmp(magic, SEGSTORE_MAGIC, sizeof(magic)) == 0;
+}
+
+static bool convert_to_segments(const std::string& in_path, const std::string& seg_path, uint32_t fields,
+                                uint32_t segment_blocks) {
+    BlockTable table;
+    if (looks_like_json(in_path)) {
+        ParseReport report;
+        if (!parse_json_file(in_path, fields, table, &report)) {
+            std::cerr << "Failed to open " << in_path << std::endl;
+            return false;
+        }
+    } else if (looks_like_csv(in_path)) {
+        if (!parse_csv_file(in_path, table, nullptr)) {
+            return false;
+        }
+    } else if (!load_txt(in_path, table)) {
+        std::cerr << "Failed to open " << in_path << std::endl;
+        return false;
+    }
+    if (!save_segments(table, seg_path, segment_blocks)) {
+        return false;
+    }
+    std::cout << "Converted " << in_path << " to " << seg_path << " (" << table.size() << " blocks)." << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* program = argv[0];
+    uint32_t fields = FIELDS_ALL;
+    long segment_blocks = 0;
+    for (;;) {
+        if (argc > 2 && std::string(argv[1]) == "--fields") {
+            if (!parse_field_list(argv[2], &fields)) {
+                std::cerr << "Unknown field in '" << argv[2] << "'" << std::endl;
+                return 1;
+            }
+        } else if (argc > 2 && std::string(argv[1]) == "--segments") {
+            segment_blocks = atol(argv[2]);
+            if (segment_blocks < 1) {
+                std::cerr << "Invalid segment size '" << argv[2] << "'" << std::endl;
+                return 1;
+            }
+        } else {
+            break;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc == 3 && std::string(argv[1]) == "--verify" && is_segment_store(argv[2])) {
+        SegmentStore store;
+        if (!store.open(argv[2])) {
+            return 1;
+        }
+        size_t bad = store.verify();
+        if (bad > 0) {
+            std::cerr << argv[2] << ": " << bad << " of " << store.segment_count() << " segment(s) corrupt"
+                      << std::endl;
+            return 1;
+        }
+        std::cout << argv[2] << ": " << store.size() << " blocks in " << store.segment_count()
+                  << " segments, checksums OK" << std::endl;
+        return 0;
+    }
+    if (argc == 3 && std::string(argv[1]) == "--verify") {
+        BlockStore store;
+        if (!store.open(argv[2])) {
+            return 1;
+        }
+        if (!store.verify()) {
+            std::cerr << argv[2] << ": checksum mismatch" << std::endl;
+            return 1;
+        }
+        std::cout << argv[2] << ": " << store.size() << " blocks, checksum OK" << std::endl;
+        return 0;
+    }
+    if (argc > 3) {
+        std::cout << "Usage:\n"
+                  << "  " << program << " [--fields hash,height,...] [info.txt|blocks.json|blocks.csv] [info.db]\n"
+                  << "  " << program << " --segments <heights> [--fields ...] [info.txt|blocks.json|blocks.csv] [info.seg]\n"
+                  << "  " << program << " --verify <info.db|info.seg>\n";
+        return 1;
+    }
+
+    std::string txt = argc > 1 ? argv[1] : "info.txt";
+    if (segment_blocks > 0) {
+        std::string seg = argc > 2 ? argv[2] : SEGSTORE_FILE;
+        if (!convert_to_segments(txt, seg, fields, (uint32_t)segment_blocks)) {
+            std::cerr << "Conversion failed." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    std::string db = argc > 2 ? argv[2] : STORE_FILE;
+    bool ok = looks_like_json(txt)  ? convert_json_to_store(txt, db, fields)
+              : looks_like_csv(txt) ? convert_csv_to_store(txt, db)
+                                    : convert_txt_to_store(txt, db);
+    if (!ok) {
+        std::cerr << "Conversion failed." << std::endl;
+        return 1;
+    }
+    std::cout << "Converted " << txt << " to " << db << " (" << countBlocks(db) << " blocks)." << std::endl;
+    return 0;
+}
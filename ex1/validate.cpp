@@ -0,0 +1,165 @@
+#include "validate.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// Heights or rows per thread below which starting another thread doesn't pay off.
+static const size_t MIN_CHUNK = 65536;
+
+const char* issue_name(ChainIssueKind kind) {
+    switch (kind) {
+        case ISSUE_GAP: return "gap";
+        case ISSUE_BROKEN_LINK: return "broken link";
+        case ISSUE_DUPLICATE_HASH: return "duplicate hash";
+        case ISSUE_DUPLICATE_HEIGHT: return "duplicate height";
+    }
+    return "issue";
+}
+
+namespace {
+
+// The blocks in height order, one per height: positions are heights above
+// the lowest one (NO_SLOT where a height has no block) when the heights are
+// indexed, otherwise positions in a sorted copy of the distinct heights.
+struct HeightSequence {
+    const BlockTable* table;
+    const HeightIndex* index;
+    int base;
+    std::vector<uint32_t> sorted;  // only without an index
+    size_t size;
+
+    uint32_t slot(size_t pos) const { return index ? index->find(base + (int)pos) : sorted[pos]; }
+    int height(size_t pos) const { return index ? base + (int)pos : table->height(sorted[pos]); }
+};
+
+void add_issue(ValidationReport* r, ChainIssueKind kind, int height, uint32_t row, uint32_t other) {
+    if (r->issues.size() < ValidationReport::MAX_ISSUES) {
+        r->issues.push_back(ChainIssue{kind, height, row, other});
+    }
+}
+
+// Pairs (pos - 1, pos) for pos in [first, last). A gap is counted at its
+// first missing position, so one that crosses a chunk boundary is only
+// counted once.
+void check_heights(const HeightSequence& seq, size_t first, size_t last, ValidationReport* r) {
+    const BlockTable& table = *seq.table;
+    for (size_t pos = std::max<size_t>(first, 1); pos < last; ++pos) {
+        uint32_t cur = seq.slot(pos);
+        uint32_t below = seq.slot(pos - 1);
+        if (cur == NO_SLOT) {
+            ++r->missing_heights;
+            if (below != NO_SLOT) {
+                size_t end = pos + 1;
+                while (end < seq.size && seq.slot(end) == NO_SLOT) ++end;
+                ++r->gaps;
+                add_issue(r, ISSUE_GAP, seq.height(pos), NO_SLOT, (uint32_t)(end - pos));
+            }
+        } else if (below != NO_SLOT) {
+            int step = seq.height(pos) - seq.height(pos - 1);
+            if (step > 1) {
+                ++r->gaps;
+                r->missing_heights += step - 1;
+                add_issue(r, ISSUE_GAP, seq.height(pos - 1) + 1, NO_SLOT, (uint32_t)(step - 1));
+            } else if (memcmp(table.prev_block(cur).bytes, table.hash(below).bytes, 32) != 0) {
+                ++r->broken_links;
+                add_issue(r, ISSUE_BROKEN_LINK, seq.height(pos), cur, below);
+            }
+        }
+    }
+}
+
+// Rows whose hash or height belongs to an earlier row.
+void check_rows(const BlockTable& table, const HashIndex& hashes, const HeightIndex* heights, size_t first,
+                size_t last, ValidationReport* r) {
+    for (size_t i = first; i < last; ++i) {
+        uint32_t owner = hashes.find(table.hash(i));
+        if (owner != (uint32_t)i) {
+            ++r->duplicate_hashes;
+            add_issue(r, ISSUE_DUPLICATE_HASH, table.height(i), (uint32_t)i, owner);
+        }
+        if (heights) {
+            owner = heights->find(table.height(i));
+            if (owner != (uint32_t)i) {
+                ++r->duplicate_heights;
+                add_issue(r, ISSUE_DUPLICATE_HEIGHT, table.height(i), (uint32_t)i, owner);
+            }
+        }
+    }
+}
+
+void merge(ValidationReport* into, const ValidationReport& part) {
+    into->gaps += part.gaps;
+    into->missing_heights += part.missing_heights;
+    into->broken_links += part.broken_links;
+    into->duplicate_hashes += part.duplicate_hashes;
+    into->duplicate_heights += part.duplicate_heights;
+    for (const ChainIssue& issue : part.issues) {
+        if (into->issues.size() >= ValidationReport::MAX_ISSUES) break;
+        into->issues.push_back(issue);
+    }
+}
+
+} // namespace
+
+void validate_chain(const BlockTable& table, const HashIndex& hashes, const HeightIndex* heights, int threads,
+                    ValidationReport* out) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t skipped = out->skipped;
+    *out = ValidationReport();
+    out->skipped = skipped;
+    size_t n = table.size();
+    out->blocks = n;
+    if (n == 0) return;
+
+    auto range = std::minmax_element(table.heights(), table.heights() + n);
+    out->min_height = *range.first;
+    out->max_height = *range.second;
+
+    HeightSequence seq{&table, heights, out->min_height, std::vector<uint32_t>(), 0};
+    ValidationReport sparse_duplicates;
+    if (heights) {
+        seq.size = (size_t)((int64_t)out->max_height - out->min_height + 1);
+    } else {
+        // Sorting is O(n log n), but only corrupt-looking chains get here.
+        std::vector<uint32_t> order(n);
+        for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+        const int32_t* h = table.heights();
+        std::stable_sort(order.begin(), order.end(), [h](uint32_t a, uint32_t b) { return h[a] < h[b]; });
+        for (size_t k = 0; k < n; ++k) {
+            if (k > 0 && h[order[k]] == h[order[k - 1]]) {
+                ++sparse_duplicates.duplicate_heights;
+                add_issue(&sparse_duplicates, ISSUE_DUPLICATE_HEIGHT, h[order[k]], order[k], seq.sorted.back());
+            } else {
+                seq.sorted.push_back(order[k]);
+            }
+        }
+        seq.size = seq.sorted.size();
+    }
+
+    size_t work = std::max(seq.size, n);
+    size_t workers = threads < 1 ? 1 : (size_t)threads;
+    workers = std::min(workers, std::max<size_t>(1, work / MIN_CHUNK));
+
+    // Worker w checks the w-th slice of the heights and the w-th slice of the rows.
+    std::vector<ValidationReport> height_parts(workers), row_parts(workers);
+    auto check = [&](size_t w) {
+        size_t per = (seq.size + workers - 1) / workers;
+        check_heights(seq, std::min(seq.size, w * per), std::min(seq.size, (w + 1) * per), &height_parts[w]);
+        per = (n + workers - 1) / workers;
+        check_rows(table, hashes, heights, std::min(n, w * per), std::min(n, (w + 1) * per), &row_parts[w]);
+    };
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w + 1 < workers; ++w) {
+        pool.emplace_back(check, w);
+    }
+    check(workers - 1);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    for (const auto& part : height_parts) merge(out, part);
+    for (const auto& part : row_parts) merge(out, part);
+    merge(out, sparse_duplicates);
+    out->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,66 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "chain.h"
+#include "blockindex.h"
+
+// Integrity check of a loaded chain; load_db() runs it on every load, so a
+// truncated or interleaved info.txt is reported instead of quietly giving
+// wrong answers.
+//
+// One pass over the heights from lowest to highest, using the hash and
+// height indexes load_db() builds anyway:
+//   - a height with no block is part of a gap,
+//   - a block whose prev_block isn't the hash of the block one height lower
+//     is a broken link,
+//   - a row that isn't the one its hash (height) maps to is a duplicate.
+// Heights and rows are split into chunks checked on separate threads. Each
+// chunk keeps its own counts and first issues and they are merged in chunk
+// order, so the report never depends on scheduling.
+
+enum ChainIssueKind {
+    ISSUE_GAP,               // heights with no block
+    ISSUE_BROKEN_LINK,       // prev_block isn't the block one height lower
+    ISSUE_DUPLICATE_HASH,    // same hash as an earlier row
+    ISSUE_DUPLICATE_HEIGHT,  // same height as an earlier row (fork or repeat)
+};
+
+struct ChainIssue {
+    ChainIssueKind kind;
+    int height;       // gap: first missing height; otherwise the block's height
+    uint32_t row;     // the block; NO_SLOT for a gap
+    uint32_t other;   // gap: heights missing; link: row one lower; duplicate: first row
+};
+
+struct ValidationReport {
+    size_t blocks = 0;
+    size_t skipped = 0;            // malformed blocks the parser dropped
+    int min_height = 0;
+    int max_height = 0;
+    size_t gaps = 0;               // runs of missing heights
+    size_t missing_heights = 0;
+    size_t broken_links = 0;
+    size_t duplicate_hashes = 0;
+    size_t duplicate_heights = 0;
+    std::vector<ChainIssue> issues;  // the first MAX_ISSUES: heights in order, then duplicates
+    double milliseconds = 0;
+
+    bool ok() const {
+        return skipped == 0 && gaps == 0 && broken_links == 0 && duplicate_hashes == 0 && duplicate_heights == 0;
+    }
+
+    static const size_t MAX_ISSUES = 32;
+};
+
+// Checks `table` against its indexes. `heights` may be null when the
+// heights were too sparse to index; the heights are then sorted instead.
+// `out->skipped` is left for the caller.
+void validate_chain(const BlockTable& table, const HashIndex& hashes, const HeightIndex* heights, int threads,
+                    ValidationReport* out);
+
+const char* issue_name(ChainIssueKind kind);
+
+#endif // VALIDATE_H
@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mta_crypt.h"
+#include "mta_rand.h"
+#include "candidate.h"
+
+// Keys per second for testing guessed keys against one ciphertext, single
+// thread: MTA_decrypt + a printable check per key (what the decrypters did)
+// against the candidate engine with a reused, rekeyed context, first
+// decrypting the whole buffer, then with the block-0 early reject, and last
+// with the block-0 step done by the multi-key RC2 kernel (rc2.h), 16 keys a
+// call. Keys are consecutive, as in the exhaustive search.
+//
+// Usage: ./bench_candidate.out [keys per run]
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void make_key(unsigned long k, unsigned int key_len, unsigned char* key) {
+    for (unsigned int i = 0; i < key_len; ++i)
+        key[i] = (unsigned char)(k >> (8 * i));
+}
+
+static bool printable_scalar(const unsigned char* buf, unsigned int len) {
+    for (unsigned int i = 0; i < len; ++i)
+        if (buf[i] < 0x20 || buf[i] > 0x7e)
+            return false;
+    return true;
+}
+
+// Rekeyed context, whole buffer decrypted for every key.
+static bool full_test(candidate_engine_t* engine, const unsigned char* key, const unsigned char* encrypted,
+                      unsigned int len, unsigned char* plain) {
+    int out_len = 0;
+    EVP_DecryptInit_ex(engine->ctx, NULL, NULL, key, NULL);
+    EVP_DecryptUpdate(engine->ctx, plain, &out_len, encrypted, (int)len);
+    return candidate_printable(plain, len);
+}
+
+int main(int argc, char** argv) {
+    unsigned long keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    if (MTA_crypt_init() != MTA_CRYPT_RET_OK) {
+        fprintf(stderr, "Failed to initialize crypto library!\n");
+        return 1;
+    }
+    unsigned int lengths[] = {16, 24, 64};
+    printf("%-8s %-34s %12s %8s %10s\n", "length", "tester", "keys/s", "speedup", "printable");
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+        unsigned int len = lengths[l], key_len = len / 8;
+        unsigned char password[64], secret[8], encrypted[64], plain[64], key[8];
+        unsigned int encrypted_len = 0, plain_len = 0;
+        for (unsigned int i = 0; i < len; ++i) password[i] = 0x20 + (unsigned char)(rand() % 95);
+        MTA_get_rand_data((char*)secret, key_len);
+        MTA_encrypt((char*)secret, key_len, (char*)password, len, (char*)encrypted, &encrypted_len);
+
+        candidate_engine_t engine;
+        if (!candidate_init(&engine, key_len)) return 1;
+        unsigned long hits[4] = {0, 0, 0, 0};
+        double seconds[4];
+        double t0 = now_sec();
+        for (unsigned long k = 0; k < keys; ++k) {
+            make_key(k, key_len, key);
+            if (MTA_decrypt((char*)key, key_len, (char*)encrypted, encrypted_len, (char*)plain, &plain_len) ==
+                    MTA_CRYPT_RET_OK && printable_scalar(plain, plain_len))
+                hits[0]++;
+        }
+        seconds[0] = now_sec() - t0;
+        t0 = now_sec();
+        for (unsigned long k = 0; k < keys; ++k) {
+            make_key(k, key_len, key);
+            hits[1] += full_test(&engine, key, encrypted, encrypted_len, plain);
+        }
+        seconds[1] = now_sec() - t0;
+        t0 = now_sec();
+        for (unsigned long k = 0; k < keys; ++k) {
+            make_key(k, key_len, key);
+            hits[2] += candidate_test(&engine, key, encrypted, encrypted_len, plain);
+        }
+        seconds[2] = now_sec() - t0;
+        t0 = now_sec();
+        unsigned char batch[CANDIDATE_BATCH * 8];
+        for (unsigned long k = 0; k < keys; k += CANDIDATE_BATCH) {
+            unsigned int count = keys - k < CANDIDATE_BATCH ? (unsigned int)(keys - k) : CANDIDATE_BATCH;
+            for (unsigned int i = 0; i < count; ++i) make_key(k + i, key_len, batch + i * key_len);
+            unsigned int mask = candidate_screen(&engine, batch, count, encrypted);
+            for (unsigned int i = 0; mask; ++i, mask >>= 1)
+                if (mask & 1) hits[3] += candidate_test(&engine, batch + i * key_len, encrypted, encrypted_len, plain);
+        }
+        seconds[3] = now_sec() - t0;
+        candidate_free(&engine);
+
+        char kernel[40];
+        snprintf(kernel, sizeof(kernel), "%s kernel x%d, block-0 screen", rc2_kernel_name(), CANDIDATE_BATCH);
+        const char* names[4] = {"MTA_decrypt + isprint", "rekeyed context, whole buffer", "rekeyed context, block-0 reject",
+                                kernel};
+        for (int r = 0; r < 4; ++r) {
+            printf("%-8u %-34s %12.0f %8.2f %10lu\n", len, names[r], keys / seconds[r], seconds[0] / seconds[r], hits[r]);
+        }
+        if (hits[1] != hits[0] || hits[2] != hits[0] || hits[3] != hits[0]) {
+            fprintf(stderr, "Testers disagree on length %u\n", len);
+            return 1;
+        }
+    }
+    return 0;
+}
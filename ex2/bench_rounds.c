@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rc2.h"
+#include "round.h"
+
+// Scaling of the decrypters' "is my round still open?" check, 1 to 64
+// threads: the old way (lock the shared mutex, read round and solved) against
+// the lock-free epoch load (round.h). Each is measured on its own, where the
+// mutex's cache line bounces between all the threads, and once per 16-key
+// block-0 screen (rc2.h), which is how often the random-mode decrypters
+// check. Numbers are totals over all threads.
+//
+// Usage: ./bench_rounds.out [milliseconds per cell]
+
+typedef struct {
+    pthread_mutex_t mutex;
+    unsigned int round;
+    bool solved;
+    round_state_t rounds;
+    pthread_barrier_t start;
+    _Atomic bool stop;
+} bench_state_t;
+
+typedef struct {
+    bench_state_t* state;
+    bool lock_free;
+    bool screen;
+    unsigned long checks;
+    double started, stopped;
+    pthread_t thread;
+} bench_thread_t;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* bench_thread(void* arg) {
+    bench_thread_t* t = arg;
+    bench_state_t* st = t->state;
+    unsigned char keys[RC2_LANES * 2], block[RC2_BLOCK] = "\x11\x22\x33\x44\x55\x66\x77\x88";
+    unsigned int sink = 0;
+    unsigned long checks = 0;
+    for (unsigned int i = 0; i < sizeof(keys); ++i) keys[i] = (unsigned char)(i * 37 + (uintptr_t)t);
+    pthread_barrier_wait(&st->start);
+    t->started = now_sec();
+    while (!atomic_load_explicit(&st->stop, memory_order_relaxed)) {
+        bool open;
+        if (t->lock_free) {
+            open = round_is_open(&st->rounds, 1);
+        } else {
+            pthread_mutex_lock(&st->mutex);
+            open = !st->solved && st->round == 1;
+            pthread_mutex_unlock(&st->mutex);
+        }
+        if (!open) break;
+        checks++;
+        if (t->screen) {
+            sink += rc2_block0_printable(keys, 2, RC2_LANES, block);
+            keys[0] += (unsigned char)sink + 1;
+        }
+    }
+    t->checks = checks;
+    t->stopped = now_sec();
+    return NULL;
+}
+
+static double run(bench_state_t* st, int threads, bool lock_free, bool screen, double seconds) {
+    bench_thread_t* ts = calloc((size_t)threads, sizeof(*ts));
+    atomic_store(&st->stop, false);
+    pthread_barrier_init(&st->start, NULL, (unsigned int)threads + 1);
+    for (int i = 0; i < threads; ++i) {
+        ts[i] = (bench_thread_t){.state = st, .lock_free = lock_free, .screen = screen};
+        pthread_create(&ts[i].thread, NULL, bench_thread, &ts[i]);
+    }
+    pthread_barrier_wait(&st->start);  // every thread is up before any starts counting
+    struct timespec wait = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&wait, NULL);
+    atomic_store(&st->stop, true);
+    unsigned long total = 0;
+    double first = 0, last = 0;
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(ts[i].thread, NULL);
+        total += ts[i].checks;
+        if (i == 0 || ts[i].started < first) first = ts[i].started;
+        if (i == 0 || ts[i].stopped > last) last = ts[i].stopped;
+    }
+    double elapsed = last - first;
+    pthread_barrier_destroy(&st->start);
+    free(ts);
+    return total / elapsed;
+}
+
+int main(int argc, char** argv) {
+    double seconds = (argc > 1 ? atof(argv[1]) : 200) / 1000;
+    bench_state_t st = {.mutex = PTHREAD_MUTEX_INITIALIZER, .round = 1};
+    if (!round_state_init(&st.rounds, 1)) return 1;
+    round_data_t* data = round_data_new(1, "", 0, 2, NULL);
+    if (!data) return 1;
+    round_publish(&st.rounds, data);
+
+    printf("%-8s %16s %16s %8s %16s %16s %8s\n", "threads", "mutex checks/s", "epoch checks/s", "ratio",
+           "mutex screens/s", "epoch screens/s", "ratio");
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        double r[4];
+        for (int m = 0; m < 4; ++m)
+            r[m] = run(&st, threads, m & 1, m & 2, seconds);
+        printf("%-8d %16.0f %16.0f %8.2f %16.0f %16.0f %8.2f\n", threads, r[0], r[1], r[1] / r[0], r[2], r[3],
+               r[3] / r[2]);
+    }
+    round_state_free(&st.rounds);
+    return 0;
+}
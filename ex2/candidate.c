@@ -0,0 +1,74 @@
+#include "candidate.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+bool candidate_init(candidate_engine_t* engine, unsigned int key_len) {
+    memset(engine, 0, sizeof(*engine));
+    engine->key_len = key_len;
+    // Fetched once: a cipher looked up by name is fetched again on every init.
+    engine->cipher = EVP_CIPHER_fetch(NULL, "RC2-ECB", NULL);
+    engine->ctx = EVP_CIPHER_CTX_new();
+    if (!engine->cipher || !engine->ctx ||
+        !EVP_DecryptInit_ex(engine->ctx, engine->cipher, NULL, NULL, NULL) ||
+        !EVP_CIPHER_CTX_set_key_length(engine->ctx, (int)key_len) ||
+        !EVP_CIPHER_CTX_set_padding(engine->ctx, 0)) {
+        fprintf(stderr, "[ERROR] RC2-ECB is not available (was MTA_crypt_init called?)\n");
+        candidate_free(engine);
+        return false;
+    }
+    return true;
+}
+
+void candidate_free(candidate_engine_t* engine) {
+    EVP_CIPHER_CTX_free(engine->ctx);
+    EVP_CIPHER_free(engine->cipher);
+    engine->ctx = NULL;
+    engine->cipher = NULL;
+}
+
+bool candidate_printable(const unsigned char* buf, unsigned int len) {
+    unsigned int i = 0;
+#ifdef __SSE2__
+    // Shifted by 0x60, ' ' .. '~' become 0x80 .. 0xde: the only bytes below
+    // 0xdf in a signed compare.
+    const __m128i shift = _mm_set1_epi8(0x60);
+    const __m128i limit = _mm_set1_epi8((char)0xdf);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(buf + i)), shift);
+        if (_mm_movemask_epi8(_mm_cmplt_epi8(v, limit)) != 0xffff) return false;
+    }
+    if (i + 8 <= len) {
+        __m128i v = _mm_add_epi8(_mm_loadl_epi64((const __m128i*)(buf + i)), shift);
+        if ((_mm_movemask_epi8(_mm_cmplt_epi8(v, limit)) & 0xff) != 0xff) return false;
+        i += 8;
+    }
+#endif
+    for (; i < len; ++i)
+        if (buf[i] < 0x20 || buf[i] > 0x7e) return false;
+    return true;
+}
+
+bool candidate_test(candidate_engine_t* engine, const unsigned char* key, const unsigned char* encrypted,
+                    unsigned int len, unsigned char* plain) {
+    int out_len = 0;
+    // Same cipher and key length as before: only the key schedule changes.
+    if (!EVP_DecryptInit_ex(engine->ctx, NULL, NULL, key, NULL)) return false;
+    if (!EVP_DecryptUpdate(engine->ctx, plain, &out_len, encrypted, RC2_BLOCK) ||
+        !candidate_printable(plain, RC2_BLOCK))
+        return false;
+    if (len > RC2_BLOCK &&
+        !EVP_DecryptUpdate(engine->ctx, plain + RC2_BLOCK, &out_len, encrypted + RC2_BLOCK, (int)(len - RC2_BLOCK)))
+        return false;
+    return candidate_printable(plain + RC2_BLOCK, len - RC2_BLOCK);
+}
+
+unsigned int candidate_screen(candidate_engine_t* engine, const unsigned char* keys, unsigned int count,
+                              const unsigned char* encrypted) {
+    if (count > CANDIDATE_BATCH) count = CANDIDATE_BATCH;
+    unsigned int all = (1u << count) - 1;
+    // Keys longer than the kernel takes (MTA refuses them anyway) all go to candidate_test()
+    return engine->key_len <= RC2_MAX_KEY_LEN ? rc2_block0_printable(keys, engine->key_len, count, encrypted) : all;
+}
@@ -0,0 +1,55 @@
+#ifndef CANDIDATE_H
+#define CANDIDATE_H
+
+#include <stdbool.h>
+#include <openssl/evp.h>
+#include "rc2.h"
+
+// Keys per candidate_screen() call.
+#define CANDIDATE_BATCH RC2_LANES
+
+// Candidate-key tester: does what MTA_decrypt + is_printable_str do for one
+// guessed key, without the per-guess setup and mostly without decrypting.
+//
+// MTA_decrypt builds a new RC2-ECB cipher context (looked up by name) for
+// every call and decrypts the whole buffer. Here each thread keeps one
+// context with the cipher and key length fixed, and a guess only rekeys it.
+// ECB decrypts each 8-byte block on its own, so block 0 is decrypted first
+// and a key whose block 0 isn't printable (all but ~1 in 2800 of them) is
+// rejected right there; only survivors get the remaining blocks decrypted
+// and checked. The printable test (' ' .. '~', isprint in the C locale)
+// looks at 16 bytes per SSE2 compare.
+//
+// candidate_screen() does the block-0 step for a batch of keys at once with
+// the native multi-key RC2 kernel (rc2.h), so a thread that has several
+// guesses at hand only calls candidate_test() for the few that survive.
+//
+// MTA_crypt_init() must have been called first (it loads the legacy
+// provider RC2 lives in).
+
+typedef struct {
+    EVP_CIPHER* cipher;
+    EVP_CIPHER_CTX* ctx;
+    unsigned int key_len;
+} candidate_engine_t;
+
+// Returns false (with a message on stderr) if RC2-ECB isn't available.
+bool candidate_init(candidate_engine_t* engine, unsigned int key_len);
+void candidate_free(candidate_engine_t* engine);
+
+// Decrypts `encrypted` (len bytes, a multiple of 8) with `key` into `plain`
+// and returns true if all of it is printable. On false, `plain` holds at
+// least the first block.
+bool candidate_test(candidate_engine_t* engine, const unsigned char* key, const unsigned char* encrypted,
+                    unsigned int len, unsigned char* plain);
+
+// Block 0 of `encrypted` under each of `count` keys (count <= CANDIDATE_BATCH,
+// key_len bytes each, back to back): bit i of the result is set if key i
+// gives a printable block and so still needs candidate_test().
+unsigned int candidate_screen(candidate_engine_t* engine, const unsigned char* keys, unsigned int count,
+                              const unsigned char* encrypted);
+
+// True if every byte of buf is printable (' ' .. '~').
+bool candidate_printable(const unsigned char* buf, unsigned int len);
+
+#endif // CANDIDATE_H
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mta_crypt.h"
+#include "rc2.h"
+
+// Checks the native RC2 code (rc2.h) against MTA_encrypt / MTA_decrypt, for
+// random keys of 1 to 64 bytes (the longest MTA takes): rc2_encrypt and
+// rc2_decrypt must give MTA's bytes exactly, and rc2_block0_printable must
+// flag exactly the keys whose MTA_decrypt of the first block is printable,
+// with the AVX2 kernel (if the CPU has it) and with the scalar one forced.
+// A quarter of the keys in each screen are the real key, so both answers
+// are exercised. Exits 1 on any mismatch.
+//
+// Usage: ./check_rc2.out [cases]    (or: make check)
+
+#define MAX_KEY_LEN 64
+#define MAX_LEN 64
+
+static unsigned int failures = 0;
+
+static void fail(unsigned long c, unsigned int key_len, const char* what) {
+    if (failures++ < 10)
+        fprintf(stderr, "case %lu, %u-byte key: %s differs from MTA\n", c, key_len, what);
+}
+
+static bool printable(const unsigned char* buf, unsigned int len) {
+    for (unsigned int i = 0; i < len; ++i)
+        if (buf[i] < 0x20 || buf[i] > 0x7e)
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    unsigned long cases = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    if (MTA_crypt_init() != MTA_CRYPT_RET_OK) {
+        fprintf(stderr, "Failed to initialize crypto library!\n");
+        return 1;
+    }
+    srand(1);
+    const char* kernels[2] = {rc2_kernel_name(), "scalar"};
+    int kernel_count = strcmp(kernels[0], "scalar") == 0 ? 1 : 2;
+    unsigned long flagged = 0;
+
+    for (unsigned long c = 0; c < cases; ++c) {
+        unsigned int key_len = 1 + (unsigned int)(c % MAX_KEY_LEN);
+        unsigned int len = RC2_BLOCK * (1 + (unsigned int)(c / MAX_KEY_LEN % (MAX_LEN / RC2_BLOCK)));
+        unsigned char secret[MAX_KEY_LEN], plain[MAX_LEN], encrypted[MAX_LEN + RC2_BLOCK], out[MAX_LEN];
+        unsigned int encrypted_len = 0;
+        for (unsigned int i = 0; i < key_len; ++i) secret[i] = (unsigned char)rand();
+        for (unsigned int i = 0; i < len; ++i) plain[i] = 0x20 + (unsigned char)(rand() % 95);
+        if (MTA_encrypt((char*)secret, key_len, (char*)plain, len, (char*)encrypted, &encrypted_len) !=
+                MTA_CRYPT_RET_OK ||
+            encrypted_len != len) {
+            fail(c, key_len, "MTA_encrypt");
+            continue;
+        }
+
+        rc2_key_t ks;
+        rc2_set_key(&ks, secret, key_len);
+        rc2_encrypt(&ks, plain, out, len);
+        if (memcmp(out, encrypted, len) != 0) fail(c, key_len, "rc2_encrypt");
+        rc2_decrypt(&ks, encrypted, out, len);
+        if (memcmp(out, plain, len) != 0) fail(c, key_len, "rc2_decrypt");
+
+        // One screen of RC2_LANES keys against the first block.
+        unsigned char keys[RC2_LANES * MAX_KEY_LEN];
+        unsigned int expected = 0;
+        for (unsigned int k = 0; k < RC2_LANES; ++k) {
+            unsigned char* key = keys + (size_t)k * key_len;
+            if (rand() % 4 == 0) memcpy(key, secret, key_len);
+            else for (unsigned int i = 0; i < key_len; ++i) key[i] = (unsigned char)rand();
+            unsigned char block[RC2_BLOCK];
+            unsigned int block_len = 0;
+            if (MTA_decrypt((char*)key, key_len, (char*)encrypted, RC2_BLOCK, (char*)block, &block_len) ==
+                    MTA_CRYPT_RET_OK &&
+                block_len == RC2_BLOCK && printable(block, RC2_BLOCK))
+                expected |= 1u << k;
+        }
+        flagged += (unsigned long)__builtin_popcount(expected);
+        unsigned int count = 1 + (unsigned int)(c % RC2_LANES);  // partial screens too
+        unsigned int want = expected & ((1u << count) - 1);
+        for (int m = 0; m < kernel_count; ++m) {
+            rc2_force_scalar(m == 1);
+            if (rc2_block0_printable(keys, key_len, count, encrypted) != want) {
+                char what[64];
+                snprintf(what, sizeof(what), "rc2_block0_printable (%s)", kernels[m]);
+                fail(c, key_len, what);
+            }
+        }
+        rc2_force_scalar(false);
+    }
+
+    printf("%lu cases, keys of 1-%d bytes, kernels:", cases, MAX_KEY_LEN);
+    for (int m = 0; m < kernel_count; ++m) printf(" %s", kernels[m]);
+    printf("; %lu keys flagged printable by MTA; %u mismatches\n", flagged, failures);
+    return failures ? 1 : 0;
+}
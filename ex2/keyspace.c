@@ -0,0 +1,99 @@
+#include "keyspace.h"
+#include <stdlib.h>
+
+static inline uint64_t pack_run(uint64_t begin, uint64_t end) {
+    return begin | (end << 32);
+}
+
+static inline uint64_t run_begin(uint64_t run) {
+    return run & 0xffffffffu;
+}
+
+static inline uint64_t run_end(uint64_t run) {
+    return run >> 32;
+}
+
+keyspace_t* keyspace_create(unsigned int key_len, int num_workers) {
+    if (key_len == 0 || key_len > KEYSPACE_MAX_KEY_LEN || num_workers < 1) return NULL;
+    keyspace_t* ks = calloc(1, sizeof(keyspace_t));
+    if (!ks) return NULL;
+    ks->workers = calloc(num_workers, sizeof(keyspace_worker_t));
+    if (!ks->workers) {
+        free(ks);
+        return NULL;
+    }
+    ks->key_len = key_len;
+    ks->key_count = 1ull << (8 * key_len);
+    // Chunk numbers must fit the 32-bit halves of a run.
+    ks->chunk_keys = KEYSPACE_CHUNK_KEYS;
+    while (ks->key_count / ks->chunk_keys > 0xffffffffull) ks->chunk_keys *= 2;
+    ks->chunk_count = (ks->key_count + ks->chunk_keys - 1) / ks->chunk_keys;
+    ks->num_workers = num_workers;
+    for (int w = 0; w < num_workers; ++w) {
+        uint64_t begin = ks->chunk_count * w / num_workers;
+        uint64_t end = ks->chunk_count * (w + 1) / num_workers;
+        atomic_init(&ks->workers[w].run, pack_run(begin, end));
+    }
+    return ks;
+}
+
+void keyspace_destroy(keyspace_t* ks) {
+    if (!ks) return;
+    free(ks->workers);
+    free(ks);
+}
+
+// Takes the front chunk of worker w's own run.
+static bool take_own(keyspace_t* ks, int w, uint64_t* chunk) {
+    _Atomic uint64_t* run = &ks->workers[w].run;
+    uint64_t cur = atomic_load_explicit(run, memory_order_relaxed);
+    while (run_begin(cur) < run_end(cur)) {
+        if (atomic_compare_exchange_weak(run, &cur, pack_run(run_begin(cur) + 1, run_end(cur)))) {
+            *chunk = run_begin(cur);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Moves the back half of the largest other run to worker w (whose own run
+// is empty). Returns false if there is nothing left anywhere.
+static bool steal(keyspace_t* ks, int w) {
+    for (;;) {
+        int victim = -1;
+        uint64_t victim_run = 0, most = 0;
+        for (int v = 0; v < ks->num_workers; ++v) {
+            uint64_t run = atomic_load_explicit(&ks->workers[v].run, memory_order_relaxed);
+            uint64_t left = run_end(run) > run_begin(run) ? run_end(run) - run_begin(run) : 0;
+            if (v != w && left > most) {
+                victim = v;
+                victim_run = run;
+                most = left;
+            }
+        }
+        if (victim < 0) return false;
+        // With one chunk left the thief takes it; otherwise the back half.
+        uint64_t mid = run_end(victim_run) - (most + 1) / 2;
+        if (atomic_compare_exchange_strong(&ks->workers[victim].run, &victim_run,
+                                           pack_run(run_begin(victim_run), mid))) {
+            // Only this thread writes its own run while it is empty; thieves
+            // skip empty runs, so a plain store is enough.
+            atomic_store(&ks->workers[w].run, pack_run(mid, run_end(victim_run)));
+            ks->workers[w].steals++;
+            return true;
+        }
+        // The victim or another thief got there first; look again.
+    }
+}
+
+bool keyspace_next(keyspace_t* ks, int worker, uint64_t* first, uint64_t* count) {
+    uint64_t chunk;
+    while (!take_own(ks, worker, &chunk)) {
+        if (!steal(ks, worker)) return false;
+    }
+    ks->workers[worker].chunks_done++;
+    *first = chunk * ks->chunk_keys;
+    *count = ks->chunk_keys;
+    if (*first + *count > ks->key_count) *count = ks->key_count - *first;
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef KEYSPACE_H
+#define KEYSPACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Exhaustive search over every key of a given length, split into chunks
+// and shared by the decrypter threads with work stealing.
+//
+// Key k (0 .. 256^key_len - 1) is the little-endian encoding of k. The
+// chunks are first dealt out as one contiguous run per worker; a worker
+// takes chunks from the front of its own run, and once that is empty it
+// steals the back half of the largest run left. A run is a (begin, end)
+// pair packed into one atomic word, so taking and stealing are single
+// compare-and-swaps and no chunk is ever handed out twice. Every key is
+// tried exactly once per round, so the worst case is the keyspace divided
+// by the number of workers, however unevenly they run.
+
+// Longest key the search covers (the key count must fit in 64 bits).
+#define KEYSPACE_MAX_KEY_LEN 7
+// Keys per chunk: large enough that the per-chunk bookkeeping (and the
+// round check the decrypters do between chunks) is noise, small enough to
+// leave plenty of chunks to balance.
+#define KEYSPACE_CHUNK_KEYS 4096
+
+typedef struct {
+    _Atomic uint64_t run;  // begin chunk in the low 32 bits, end chunk in the high 32
+    unsigned long chunks_done;
+    unsigned long steals;
+} keyspace_worker_t;
+
+typedef struct {
+    unsigned int key_len;
+    uint64_t key_count;
+    uint64_t chunk_keys;
+    uint64_t chunk_count;
+    int num_workers;
+    keyspace_worker_t* workers;
+} keyspace_t;
+
+// NULL if key_len is 0 or over KEYSPACE_MAX_KEY_LEN, or out of memory.
+keyspace_t* keyspace_create(unsigned int key_len, int num_workers);
+void keyspace_destroy(keyspace_t* ks);
+
+// Hands worker `worker` (0-based) its next chunk: keys [*first, *first +
+// *count). Returns false once every chunk has been handed out.
+bool keyspace_next(keyspace_t* ks, int worker, uint64_t* first, uint64_t* count);
+
+// Writes key number `index` into `key` (ks->key_len bytes).
+static inline void keyspace_key(const keyspace_t* ks, uint64_t index, unsigned char* key) {
+    for (unsigned int i = 0; i < ks->key_len; ++i) {
+        key[i] = (unsigned char)(index >> (8 * i));
+    }
+}
+
+#endif // KEYSPACE_H
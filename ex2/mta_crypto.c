@@ -14,22 +14,25 @@
 #include "mta_crypt.h"
 #include "mta_rand.h"
 #include <openssl/evp.h>
-
-// Shared data structure for all threads (server and clients)
+#include "keyspace.h"
+#include "candidate.h"
+#include "round.h"
+#include "xoshiro.h"
+
+// Shared data structure for all threads (server and clients). The round
+// itself (ciphertext, keyspace, open/solved) is in `rounds`, which the
+// clients read without locking (see round.h); the mutex guards the rest,
+// which is only needed to check and accept solutions.
 typedef struct {
-    char* encrypted_data;
-    unsigned int encrypted_len;
+    round_state_t rounds;
     char* key;
     unsigned int key_len;
     char* original_password;
     unsigned int password_len;
-    bool solved;
     char* solution;
     int winner_id;
     pthread_mutex_t mutex;
-    pthread_cond_t new_data;
     pthread_cond_t solved_cond;
-    unsigned int round;
 } shared_t;
 
 // Argument struct for each decrypter thread
@@ -42,6 +45,8 @@ typedef struct {
 int num_decrypters = 0;
 unsigned int password_len = 0;
 int timeout_sec = INT_MAX;
+bool random_mode = false;  // -m random: guess random keys instead
+unsigned int batch_size = 256;  // -b: keys per decrypter batch
 
 // Utility: get current timestamp (seconds)
 long get_timestamp() {
@@ -73,12 +78,9 @@ void generate_random_printable(char* buf, unsigned int len) {
     }
 }
 
-// Check if all bytes in buffer are printable chars
-bool is_printable_str(const char* buf, unsigned int len) {
-    for (unsigned int i = 0; i < len; ++i)
-        if (!isprint((unsigned char)buf[i]))
-            return false;
-    return true;
+// True once the current round has been solved.
+static bool round_solved(shared_t* shared) {
+    return round_epoch(&shared->rounds) & 1;
 }
 
 // The encrypter (server) thread: generates, encrypts, and shares passwords
@@ -109,23 +111,30 @@ void* encrypter_thread(void* arg) {
             continue;
         }
 
+        // The round the clients will see: ciphertext and (exhaustive mode) keyspace
+        keyspace_t* keyspace = random_mode ? NULL : keyspace_create(key_len, num_decrypters);
+        round_data_t* data = round_data_new(round + 1, encrypted, encrypted_len, key_len, keyspace);
+        if (!data) {
+            fprintf(stderr, "[SERVER]\t[ERROR] Out of memory for a new round\n");
+            keyspace_destroy(keyspace);
+            free(password); free(key); free(encrypted);
+            sleep(1);
+            continue;
+        }
+
         // Lock and update shared data for new round
         pthread_mutex_lock(&shared->mutex);
-        if (shared->encrypted_data) free(shared->encrypted_data);
         if (shared->key) free(shared->key);
         if (shared->original_password) free(shared->original_password);
         if (shared->solution) free(shared->solution);
 
-        shared->encrypted_data = encrypted;
-        shared->encrypted_len = encrypted_len;
         shared->password_len = password_len;
         shared->key = key;
         shared->key_len = key_len;
         shared->original_password = strndup(password, password_len);
-        shared->solved = false;
         shared->solution = NULL;
         shared->winner_id = -1;
-        shared->round = ++round;
+        ++round;
 
         // Print info about new password
         printf("%ld\t[SERVER]\t[INFO] New password generated: ", get_timestamp());
@@ -135,8 +144,10 @@ void* encrypter_thread(void* arg) {
         printf(", After encryption: %.*s",encrypted_len,encrypted);
         printf("\n");
 
-        pthread_cond_broadcast(&shared->new_data);
+        // Opens the round and wakes the clients
+        round_publish(&shared->rounds, data);
         pthread_mutex_unlock(&shared->mutex);
+        free(encrypted);
 
         // Wait for either a solution or a timeout
         struct timespec ts;
@@ -145,10 +156,10 @@ void* encrypter_thread(void* arg) {
 
         pthread_mutex_lock(&shared->mutex);
         int rc = 0;
-        while (!shared->solved && rc != ETIMEDOUT) {
+        while (!round_solved(shared) && rc != ETIMEDOUT) {
             rc = pthread_cond_timedwait(&shared->solved_cond, &shared->mutex, &ts);
         }
-        if (shared->solved) {
+        if (round_solved(shared)) {
             printf("%ld\t[SERVER]\t[OK] Password decrypted successfully by client #%d, received(", get_timestamp(), shared->winner_id);
             print_str(shared->solution, shared->password_len);
             printf("), is (");
@@ -164,7 +175,124 @@ void* encrypter_thread(void* arg) {
     return NULL;
 }
 
-// Each decrypter (client) thread: brute-forces the key and submits solutions
+// Most printable decryptions held back before they are submitted.
+#define SUBMIT_MAX 8
+
+// One decrypter's guessing pipeline. Its buffers are sized once, when the
+// thread starts, and reused for every batch of every round, so guessing
+// allocates nothing: a batch of keys is generated in place, screened and
+// tested as a unit (run_batch), and its printable decryptions are
+// submitted together under one lock.
+typedef struct {
+    unsigned int size;  // keys per batch (-b)
+    unsigned int key_len;
+    unsigned char* keys;  // size * key_len
+    xoshiro_t rng;        // random mode's key source
+    unsigned int hit_count;
+    unsigned int hit_key[SUBMIT_MAX];  // index into keys
+    unsigned long hit_iterations[SUBMIT_MAX];
+    char* hit_plain;  // SUBMIT_MAX decryptions of password_len bytes
+} pipeline_t;
+
+static bool pipeline_init(pipeline_t* p, unsigned int size, unsigned int key_len) {
+    unsigned char seed[32];
+    memset(p, 0, sizeof(*p));
+    p->size = size;
+    p->key_len = key_len;
+    p->keys = malloc((size_t)size * key_len);
+    p->hit_plain = malloc((size_t)SUBMIT_MAX * password_len);
+    if (!p->keys || !p->hit_plain) {
+        free(p->keys);
+        free(p->hit_plain);
+        return false;
+    }
+    MTA_get_rand_data((char*)seed, sizeof(seed));
+    xoshiro_seed(&p->rng, seed);
+    return true;
+}
+
+static void pipeline_free(pipeline_t* p) {
+    free(p->keys);
+    free(p->hit_plain);
+}
+
+// Reports the pipeline's printable decryptions and submits them to the
+// server, all under one lock. Returns false if the round has moved on.
+static bool submit_hits(shared_t* shared, int id, unsigned int round, pipeline_t* p) {
+    unsigned int count = p->hit_count;
+    p->hit_count = 0;
+
+    // Print info about each printable decryption attempt
+    for (unsigned int h = 0; h < count; ++h) {
+        printf("%ld\t[CLIENT #%d]\t[INFO] After decryption(", get_timestamp(), id);
+        print_str(p->hit_plain + (size_t)h * password_len, password_len);
+        printf("), key guessed(");
+        print_hex((const char*)p->keys + (size_t)p->hit_key[h] * p->key_len, p->key_len);
+        printf("), sending to server after %lu iterations\n", p->hit_iterations[h]);
+    }
+
+    pthread_mutex_lock(&shared->mutex);
+    // Out-of-order check
+    uint32_t epoch = round_epoch(&shared->rounds);
+    if (epoch != ROUND_EPOCH(round, 0) && epoch != ROUND_EPOCH(round, 1)) {
+        pthread_mutex_unlock(&shared->mutex);
+        return false;
+    }
+    bool solved = epoch & 1;
+    for (unsigned int h = 0; h < count && !solved; ++h) {
+        const char* decrypted = p->hit_plain + (size_t)h * password_len;
+        // If correct, update shared state and notify server
+        if (memcmp(p->keys + (size_t)p->hit_key[h] * p->key_len, shared->key, p->key_len) == 0) {
+            solved = round_mark_solved(&shared->rounds, round);
+            shared->solution = strndup(decrypted, password_len);
+            shared->winner_id = id;
+            pthread_cond_signal(&shared->solved_cond);
+        } else {
+            // Wrong password, print error
+            printf("%ld\t[SERVER]\t[ERROR] Wrong password received from client #%d(", get_timestamp(), id);
+            print_str(decrypted, password_len);
+            printf("), should be (");
+            print_str(shared->original_password, shared->password_len);
+            printf(")\n");
+        }
+    }
+    pthread_mutex_unlock(&shared->mutex);
+    return true;
+}
+
+// Tests the first `count` keys of the pipeline against the round's
+// ciphertext: the block-0 screen CANDIDATE_BATCH keys at a time (see
+// candidate.h), the full test for its survivors, then one submission for
+// the batch's printable decryptions. `iterations` is the number of keys
+// tried this round before the batch. Returns false if the round has moved on.
+static bool run_batch(shared_t* shared, int id, unsigned int round, candidate_engine_t* engine, pipeline_t* p,
+                      unsigned int count, const char* encrypted, unsigned int encrypted_len, unsigned long iterations) {
+    if (encrypted_len != password_len) return true;
+    for (unsigned int b = 0; b < count; b += CANDIDATE_BATCH) {
+        unsigned int n = count - b < CANDIDATE_BATCH ? count - b : CANDIDATE_BATCH;
+        const unsigned char* keys = p->keys + (size_t)b * p->key_len;
+        unsigned int survivors = candidate_screen(engine, keys, n, (const unsigned char*)encrypted);
+        for (unsigned int i = 0; survivors; ++i, survivors >>= 1) {
+            char* plain = p->hit_plain + (size_t)p->hit_count * password_len;
+            if (!(survivors & 1) ||
+                !candidate_test(engine, keys + (size_t)i * p->key_len, (const unsigned char*)encrypted, encrypted_len,
+                                (unsigned char*)plain))
+                continue;
+            p->hit_key[p->hit_count] = b + i;
+            p->hit_iterations[p->hit_count] = iterations + b + i + 1;
+            if (++p->hit_count == SUBMIT_MAX && !submit_hits(shared, id, round, p))
+                return false;
+        }
+    }
+    return p->hit_count == 0 || submit_hits(shared, id, round, p);
+}
+
+// Each decrypter (client) thread: brute-forces the key and submits solutions.
+// By default it works through its share of the round's keyspace (see
+// keyspace.h), checking between chunks whether the round is still open;
+// with -m random it guesses keys from its own xoshiro generator. Either
+// way keys go through the pipeline a batch at a time. Neither the wait for
+// a round nor the open check takes the mutex (see round.h).
 void* decrypter_thread(void* arg) {
     decrypter_arg_t* my_arg = (decrypter_arg_t*)arg;
     shared_t* shared = my_arg->shared;
@@ -178,87 +306,62 @@ void* decrypter_thread(void* arg) {
         return NULL;
     }
 
-    char* local_encrypted = malloc(password_len);
-    unsigned int local_encrypted_len = 0;
-    unsigned int local_key_len = password_len / 8;
+    // One cipher context per thread, rekeyed for every guess
+    candidate_engine_t engine;
+    if (!candidate_init(&engine, password_len / 8))
+        return NULL;
+    pipeline_t pipeline;
+    if (!pipeline_init(&pipeline, batch_size, engine.key_len)) {
+        fprintf(stderr, "[CLIENT #%d]\t[ERROR] Out of memory for a batch of %u keys\n", id, batch_size);
+        candidate_free(&engine);
+        return NULL;
+    }
 
     while (1) {
-        // Wait for new round
-        pthread_mutex_lock(&shared->mutex);
-        while (shared->round == last_round)
-            pthread_cond_wait(&shared->new_data, &shared->mutex);
-
-        if (shared->encrypted_data && shared->encrypted_len > 0) {
-            memcpy(local_encrypted, shared->encrypted_data, shared->encrypted_len);
-            local_encrypted_len = shared->encrypted_len;
-            local_key_len = shared->key_len;
-            last_round = shared->round;
-        }
-        pthread_mutex_unlock(&shared->mutex);
+        // Wait for new round; its data stays ours (read in place) until released
+        round_data_t* data = round_acquire(&shared->rounds, id - 1, last_round);
+        const char* local_encrypted = data->encrypted;
+        unsigned int local_encrypted_len = data->encrypted_len;
+        keyspace_t* keyspace = data->keyspace;
+        last_round = data->round;
 
         iterations = 0;
 
-        // Start brute-forcing
-        while (1) {
-            pthread_mutex_lock(&shared->mutex);
-            bool solved = shared->solved;
-            unsigned int current_round = shared->round;
-            pthread_mutex_unlock(&shared->mutex);
-
-            if (solved || current_round != last_round)
-                break;
-
-            iterations++;
-            char* guess_key = malloc(local_key_len);
-            MTA_get_rand_data(guess_key, local_key_len);
-
-            char* decrypted = malloc(password_len);
-            unsigned int decrypted_len = 0;
-            if (MTA_decrypt(guess_key, local_key_len, local_encrypted, local_encrypted_len, decrypted, &decrypted_len) == MTA_CRYPT_RET_OK) {
-                if (decrypted_len == password_len && is_printable_str(decrypted, decrypted_len)) {
-                    // Print info about each printable decryption attempt
-                    printf("%ld\t[CLIENT #%d]\t[INFO] After decryption(", get_timestamp(), id);
-                    print_str(decrypted, decrypted_len);
-                    printf("), key guessed(");
-                    print_hex(guess_key, local_key_len);
-                    printf("), sending to server after %lu iterations\n", iterations);
-
-                    pthread_mutex_lock(&shared->mutex);
-                    // Out-of-order check
-                    if (shared->round != last_round) {
-                        pthread_mutex_unlock(&shared->mutex);
-                        free(guess_key);
-                        free(decrypted);
-                        break;
-                    }
-                    // If correct, update shared state and notify server
-                    if (!shared->solved && memcmp(guess_key, shared->key, local_key_len) == 0) {
-                        shared->solved = true;
-                        shared->solution = strndup(decrypted, decrypted_len);
-                        shared->winner_id = id;
-                        pthread_cond_signal(&shared->solved_cond);
-                    } else if (!shared->solved) {
-                        // Wrong password, print error
-                        printf("%ld\t[SERVER]\t[ERROR] Wrong password received from client #%d(", get_timestamp(), id);
-                        print_str(decrypted, decrypted_len);
-                        printf("), should be (");
-                        print_str(shared->original_password, shared->password_len);
-                        printf(")\n");
-                    }
-                    pthread_mutex_unlock(&shared->mutex);
+        if (keyspace) {
+            // Exhaustive search: every key of the round is tried by exactly one thread
+            uint64_t first, count;
+            bool open = true;
+            while (open && round_is_open(&shared->rounds, last_round) && keyspace_next(keyspace, id - 1, &first, &count)) {
+                for (uint64_t k = first; k < first + count && open; ) {
+                    unsigned int n = first + count - k < pipeline.size ? (unsigned int)(first + count - k) : pipeline.size;
+                    for (unsigned int i = 0; i < n; ++i)
+                        keyspace_key(keyspace, k + i, pipeline.keys + (size_t)i * pipeline.key_len);
+                    open = run_batch(shared, id, last_round, &engine, &pipeline, n, local_encrypted,
+                                     local_encrypted_len, iterations);
+                    iterations += n;
+                    k += n;
                 }
             }
-            free(guess_key);
-            free(decrypted);
+        } else {
+            // Random guessing
+            bool open = true;
+            while (open && round_is_open(&shared->rounds, last_round)) {
+                xoshiro_fill(&pipeline.rng, pipeline.keys, (size_t)pipeline.size * pipeline.key_len);
+                open = run_batch(shared, id, last_round, &engine, &pipeline, pipeline.size, local_encrypted,
+                                 local_encrypted_len, iterations);
+                iterations += pipeline.size;
+            }
         }
+        round_release(&shared->rounds, id - 1);
     }
-    free(local_encrypted);
+    pipeline_free(&pipeline);
+    candidate_free(&engine);
     return NULL;
 }
 
 // Print usage message in the format required by the assignment
 void print_usage(const char* prog) {
-    fprintf(stderr, "Usage: %s [-t|--timeout <seconds>] <-n|--num-of-decrypters <number>> <-l|--password-length <length>>\n", prog);
+    fprintf(stderr, "Usage: %s [-t|--timeout <seconds>] [-m|--mode <exhaustive|random>] [-b|--batch <keys>] <-n|--num-of-decrypters <number>> <-l|--password-length <length>>\n", prog);
 }
 
 // Parse command-line arguments and validate required flags
@@ -267,11 +370,13 @@ void parse_args(int argc, char** argv) {
         {"num-of-decrypters", required_argument, 0, 'n'},
         {"password-length", required_argument, 0, 'l'},
         {"timeout", required_argument, 0, 't'},
+        {"mode", required_argument, 0, 'm'},
+        {"batch", required_argument, 0, 'b'},
         {0, 0, 0, 0}
     };
     int c;
-    bool got_n = false, got_l = false;
-    while ((c = getopt_long(argc, argv, "n:l:t:", long_opts, NULL)) != -1) {
+    bool got_n = false, got_l = false, got_m = false;
+    while ((c = getopt_long(argc, argv, "n:l:t:m:b:", long_opts, NULL)) != -1) {
         switch (c) {
             case 'n':
                 num_decrypters = atoi(optarg);
@@ -284,6 +389,26 @@ void parse_args(int argc, char** argv) {
             case 't':
                 timeout_sec = atoi(optarg);
                 break;
+            case 'm':
+                if (strcmp(optarg, "random") == 0) {
+                    random_mode = true;
+                } else if (strcmp(optarg, "exhaustive") == 0) {
+                    random_mode = false;
+                } else {
+                    fprintf(stderr, "Unknown mode '%s'\n", optarg);
+                    goto print_usage_label;
+                }
+                got_m = true;
+                break;
+            case 'b': {
+                long n = atol(optarg);
+                if (n < 1 || n > 65536) {
+                    fprintf(stderr, "Batch size must be between 1 and 65536 keys\n");
+                    exit(1);
+                }
+                batch_size = (unsigned int)n;
+                break;
+            }
             default:
                 goto print_usage_label;
         }
@@ -300,6 +425,15 @@ void parse_args(int argc, char** argv) {
         fprintf(stderr, "Password length must be a multiple of 8!\n");
         exit(1);
     }
+    if (!random_mode && password_len / 8 > KEYSPACE_MAX_KEY_LEN) {
+        if (got_m) {
+            fprintf(stderr, "Exhaustive search covers passwords up to %d characters; use -m random\n",
+                    KEYSPACE_MAX_KEY_LEN * 8);
+            exit(1);
+        }
+        // Only the default was exhaustive: longer passwords are guessed at random.
+        random_mode = true;
+    }
     return;
 
 print_usage_label:
@@ -319,9 +453,10 @@ int main(int argc, char** argv) {
     // Initialize shared data and synchronization primitives
     shared_t shared = {
         .mutex = PTHREAD_MUTEX_INITIALIZER,
-        .new_data = PTHREAD_COND_INITIALIZER,
         .solved_cond = PTHREAD_COND_INITIALIZER
     };
+    if (!round_state_init(&shared.rounds, num_decrypters))
+        exit(EXIT_FAILURE);
 
     // Start encrypter (server) thread
     pthread_t enc_thread;
@@ -342,9 +477,9 @@ int main(int argc, char** argv) {
         pthread_join(dec_threads[i], NULL);
 
     // Free resources (not really reached)
-    free(shared.encrypted_data);
     free(shared.key);
     free(shared.original_password);
     free(shared.solution);
+    round_state_free(&shared.rounds);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "rc2.h"
+#include <stdatomic.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define RC2_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Effective key bits: the RC2-ECB default in OpenSSL 3, which MTA doesn't change.
+#define RC2_EFFECTIVE_BITS 128
+
+// "Random" permutation of 0..255 from the digits of pi (RFC 2268), in
+// 32-bit entries so the AVX2 kernel can gather from it as it is.
+static const int32_t rc2_pitable[256] = {
+    0xd9, 0x78, 0xf9, 0xc4, 0x19, 0xdd, 0xb5, 0xed, 0x28, 0xe9, 0xfd, 0x79, 0x4a, 0xa0, 0xd8, 0x9d,
+    0xc6, 0x7e, 0x37, 0x83, 0x2b, 0x76, 0x53, 0x8e, 0x62, 0x4c, 0x64, 0x88, 0x44, 0x8b, 0xfb, 0xa2,
+    0x17, 0x9a, 0x59, 0xf5, 0x87, 0xb3, 0x4f, 0x13, 0x61, 0x45, 0x6d, 0x8d, 0x09, 0x81, 0x7d, 0x32,
+    0xbd, 0x8f, 0x40, 0xeb, 0x86, 0xb7, 0x7b, 0x0b, 0xf0, 0x95, 0x21, 0x22, 0x5c, 0x6b, 0x4e, 0x82,
+    0x54, 0xd6, 0x65, 0x93, 0xce, 0x60, 0xb2, 0x1c, 0x73, 0x56, 0xc0, 0x14, 0xa7, 0x8c, 0xf1, 0xdc,
+    0x12, 0x75, 0xca, 0x1f, 0x3b, 0xbe, 0xe4, 0xd1, 0x42, 0x3d, 0xd4, 0x30, 0xa3, 0x3c, 0xb6, 0x26,
+    0x6f, 0xbf, 0x0e, 0xda, 0x46, 0x69, 0x07, 0x57, 0x27, 0xf2, 0x1d, 0x9b, 0xbc, 0x94, 0x43, 0x03,
+    0xf8, 0x11, 0xc7, 0xf6, 0x90, 0xef, 0x3e, 0xe7, 0x06, 0xc3, 0xd5, 0x2f, 0xc8, 0x66, 0x1e, 0xd7,
+    0x08, 0xe8, 0xea, 0xde, 0x80, 0x52, 0xee, 0xf7, 0x84, 0xaa, 0x72, 0xac, 0x35, 0x4d, 0x6a, 0x2a,
+    0x96, 0x1a, 0xd2, 0x71, 0x5a, 0x15, 0x49, 0x74, 0x4b, 0x9f, 0xd0, 0x5e, 0x04, 0x18, 0xa4, 0xec,
+    0xc2, 0xe0, 0x41, 0x6e, 0x0f, 0x51, 0xcb, 0xcc, 0x24, 0x91, 0xaf, 0x50, 0xa1, 0xf4, 0x70, 0x39,
+    0x99, 0x7c, 0x3a, 0x85, 0x23, 0xb8, 0xb4, 0x7a, 0xfc, 0x02, 0x36, 0x5b, 0x25, 0x55, 0x97, 0x31,
+    0x2d, 0x5d, 0xfa, 0x98, 0xe3, 0x8a, 0x92, 0xae, 0x05, 0xdf, 0x29, 0x10, 0x67, 0x6c, 0xba, 0xc9,
+    0xd3, 0x00, 0xe6, 0xcf, 0xe1, 0x9e, 0xa8, 0x2c, 0x63, 0x16, 0x01, 0x3f, 0x58, 0xe2, 0x89, 0xa9,
+    0x0d, 0x38, 0x34, 0x1b, 0xab, 0x33, 0xff, 0xb0, 0xbb, 0x48, 0x0c, 0x5f, 0xb9, 0xb1, 0xcd, 0x2e,
+    0xc5, 0xf3, 0xdb, 0x47, 0xe5, 0xa5, 0x9c, 0x77, 0x0a, 0xa6, 0x20, 0x68, 0xfe, 0x7f, 0xc1, 0xad,
+};
+
+void rc2_set_key(rc2_key_t* ks, const unsigned char* key, unsigned int key_len) {
+    unsigned char l[128];
+    if (key_len > RC2_MAX_KEY_LEN) key_len = RC2_MAX_KEY_LEN;
+    memcpy(l, key, key_len);
+    for (unsigned int i = key_len; i < 128; ++i)
+        l[i] = (unsigned char)rc2_pitable[(l[i - 1] + l[i - key_len]) & 0xff];
+    // Reduce to the effective key bits: t8 bytes, the top byte masked.
+    unsigned int t8 = (RC2_EFFECTIVE_BITS + 7) / 8;
+    unsigned int tm = 0xff >> (8 * t8 - RC2_EFFECTIVE_BITS);
+    l[128 - t8] = (unsigned char)rc2_pitable[l[128 - t8] & tm];
+    for (int i = 127 - (int)t8; i >= 0; --i)
+        l[i] = (unsigned char)rc2_pitable[l[i + 1] ^ l[i + t8]];
+    for (int i = 0; i < 64; ++i)
+        ks->k[i] = (uint16_t)(l[2 * i] | (l[2 * i + 1] << 8));
+}
+
+static inline uint16_t rotl16(uint16_t x, int n) {
+    return (uint16_t)((x << n) | (x >> (16 - n)));
+}
+
+static inline uint16_t rotr16(uint16_t x, int n) {
+    return (uint16_t)((x >> n) | (x << (16 - n)));
+}
+
+void rc2_encrypt(const rc2_key_t* ks, const unsigned char* in, unsigned char* out, size_t len) {
+    const uint16_t* k = ks->k;
+    for (size_t b = 0; b + RC2_BLOCK <= len; b += RC2_BLOCK) {
+        uint16_t r0 = (uint16_t)(in[b] | in[b + 1] << 8), r1 = (uint16_t)(in[b + 2] | in[b + 3] << 8);
+        uint16_t r2 = (uint16_t)(in[b + 4] | in[b + 5] << 8), r3 = (uint16_t)(in[b + 6] | in[b + 7] << 8);
+        int j = 0;
+        for (int round = 0; round < 16; ++round) {
+            r0 = rotl16((uint16_t)(r0 + k[j++] + (r3 & r2) + (~r3 & r1)), 1);
+            r1 = rotl16((uint16_t)(r1 + k[j++] + (r0 & r3) + (~r0 & r2)), 2);
+            r2 = rotl16((uint16_t)(r2 + k[j++] + (r1 & r0) + (~r1 & r3)), 3);
+            r3 = rotl16((uint16_t)(r3 + k[j++] + (r2 & r1) + (~r2 & r0)), 5);
+            if (round == 4 || round == 10) {  // mashing after mixing rounds 5 and 11
+                r0 = (uint16_t)(r0 + k[r3 & 63]);
+                r1 = (uint16_t)(r1 + k[r0 & 63]);
+                r2 = (uint16_t)(r2 + k[r1 & 63]);
+                r3 = (uint16_t)(r3 + k[r2 & 63]);
+            }
+        }
+        out[b] = (unsigned char)r0, out[b + 1] = (unsigned char)(r0 >> 8);
+        out[b + 2] = (unsigned char)r1, out[b + 3] = (unsigned char)(r1 >> 8);
+        out[b + 4] = (unsigned char)r2, out[b + 5] = (unsigned char)(r2 >> 8);
+        out[b + 6] = (unsigned char)r3, out[b + 7] = (unsigned char)(r3 >> 8);
+    }
+}
+
+void rc2_decrypt(const rc2_key_t* ks, const unsigned char* in, unsigned char* out, size_t len) {
+    const uint16_t* k = ks->k;
+    for (size_t b = 0; b + RC2_BLOCK <= len; b += RC2_BLOCK) {
+        uint16_t r0 = (uint16_t)(in[b] | in[b + 1] << 8), r1 = (uint16_t)(in[b + 2] | in[b + 3] << 8);
+        uint16_t r2 = (uint16_t)(in[b + 4] | in[b + 5] << 8), r3 = (uint16_t)(in[b + 6] | in[b + 7] << 8);
+        int j = 63;
+        for (int round = 15; round >= 0; --round) {
+            r3 = (uint16_t)(rotr16(r3, 5) - k[j--] - (r2 & r1) - (~r2 & r0));
+            r2 = (uint16_t)(rotr16(r2, 3) - k[j--] - (r1 & r0) - (~r1 & r3));
+            r1 = (uint16_t)(rotr16(r1, 2) - k[j--] - (r0 & r3) - (~r0 & r2));
+            r0 = (uint16_t)(rotr16(r0, 1) - k[j--] - (r3 & r2) - (~r3 & r1));
+            if (round == 11 || round == 5) {  // undo the mashing
+                r3 = (uint16_t)(r3 - k[r2 & 63]);
+                r2 = (uint16_t)(r2 - k[r1 & 63]);
+                r1 = (uint16_t)(r1 - k[r0 & 63]);
+                r0 = (uint16_t)(r0 - k[r3 & 63]);
+            }
+        }
+        out[b] = (unsigned char)r0, out[b + 1] = (unsigned char)(r0 >> 8);
+        out[b + 2] = (unsigned char)r1, out[b + 3] = (unsigned char)(r1 >> 8);
+        out[b + 4] = (unsigned char)r2, out[b + 5] = (unsigned char)(r2 >> 8);
+        out[b + 6] = (unsigned char)r3, out[b + 7] = (unsigned char)(r3 >> 8);
+    }
+}
+
+static unsigned int block0_printable_scalar(const unsigned char* keys, unsigned int key_len, unsigned int count,
+                                            const unsigned char in[RC2_BLOCK]) {
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        rc2_key_t ks;
+        unsigned char out[RC2_BLOCK];
+        rc2_set_key(&ks, keys + (size_t)i * key_len, key_len);
+        rc2_decrypt(&ks, in, out, RC2_BLOCK);
+        bool ok = true;
+        for (int b = 0; b < RC2_BLOCK; ++b)
+            ok = ok && out[b] >= 0x20 && out[b] <= 0x7e;
+        mask |= (unsigned int)ok << i;
+    }
+    return mask;
+}
+
+#ifdef RC2_HAVE_AVX2
+#define RC2_AVX2 __attribute__((target("avx2")))
+#define RC2_GROUPS (RC2_LANES / 8)
+
+// rotl/rotr of the 16-bit values held in 32-bit lanes.
+RC2_AVX2 static inline __m256i rotr16x8(__m256i x, int n, __m256i lo16) {
+    return _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 16 - n)), lo16);
+}
+
+// Printable lanes of one 16-bit word: both bytes in ' ' .. '~'.
+RC2_AVX2 static inline __m256i printable16x8(__m256i r) {
+    const __m256i below = _mm256_set1_epi32(0x1f), above = _mm256_set1_epi32(0x7f);
+    __m256i lo = _mm256_and_si256(r, _mm256_set1_epi32(0xff)), hi = _mm256_srli_epi32(r, 8);
+    return _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(lo, below), _mm256_cmpgt_epi32(above, lo)),
+                            _mm256_and_si256(_mm256_cmpgt_epi32(hi, below), _mm256_cmpgt_epi32(above, hi)));
+}
+
+RC2_AVX2 static unsigned int block0_printable_avx2(const unsigned char* keys, unsigned int key_len, unsigned int count,
+                                                   const unsigned char in[RC2_BLOCK]) {
+    const __m256i byte = _mm256_set1_epi32(0xff), lo16 = _mm256_set1_epi32(0xffff);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), k_mask = _mm256_set1_epi32(63);
+    __m256i l[RC2_GROUPS][128];
+    int32_t ktab[RC2_GROUPS][64 * 8];  // ktab[g][j * 8 + lane]: K[j] of that lane, for the mashing gathers
+
+    // Key bytes, transposed to one vector per byte position (missing keys are zeros).
+    for (unsigned int i = 0; i < key_len; ++i) {
+        for (int g = 0; g < RC2_GROUPS; ++g) {
+            int32_t bytes[8];
+            for (int x = 0; x < 8; ++x) {
+                unsigned int k = (unsigned int)(g * 8 + x);
+                bytes[x] = k < count ? keys[(size_t)k * key_len + i] : 0;
+            }
+            l[g][i] = _mm256_loadu_si256((const __m256i*)bytes);
+        }
+    }
+    // Key expansion as in rc2_set_key, one gather per byte per group.
+    for (unsigned int i = key_len; i < 128; ++i)
+        for (int g = 0; g < RC2_GROUPS; ++g)
+            l[g][i] = _mm256_i32gather_epi32(rc2_pitable, _mm256_and_si256(_mm256_add_epi32(l[g][i - 1], l[g][i - key_len]), byte), 4);
+    const unsigned int t8 = (RC2_EFFECTIVE_BITS + 7) / 8;
+    const __m256i tm = _mm256_set1_epi32(0xff >> (8 * t8 - RC2_EFFECTIVE_BITS));
+    for (int g = 0; g < RC2_GROUPS; ++g)
+        l[g][128 - t8] = _mm256_i32gather_epi32(rc2_pitable, _mm256_and_si256(l[g][128 - t8], tm), 4);
+    for (int i = 127 - (int)t8; i >= 0; --i)
+        for (int g = 0; g < RC2_GROUPS; ++g)
+            l[g][i] = _mm256_i32gather_epi32(rc2_pitable, _mm256_xor_si256(l[g][i + 1], l[g][i + t8]), 4);
+    __m256i k[RC2_GROUPS][64];
+    for (int j = 0; j < 64; ++j)
+        for (int g = 0; g < RC2_GROUPS; ++g) {
+            k[g][j] = _mm256_or_si256(l[g][2 * j], _mm256_slli_epi32(l[g][2 * j + 1], 8));
+            _mm256_storeu_si256((__m256i*)(ktab[g] + j * 8), k[g][j]);
+        }
+
+    // rc2_decrypt of the one block, every lane starting from the same words.
+    __m256i r0[RC2_GROUPS], r1[RC2_GROUPS], r2[RC2_GROUPS], r3[RC2_GROUPS];
+    for (int g = 0; g < RC2_GROUPS; ++g) {
+        r0[g] = _mm256_set1_epi32(in[0] | in[1] << 8);
+        r1[g] = _mm256_set1_epi32(in[2] | in[3] << 8);
+        r2[g] = _mm256_set1_epi32(in[4] | in[5] << 8);
+        r3[g] = _mm256_set1_epi32(in[6] | in[7] << 8);
+    }
+    int j = 63;
+    for (int round = 15; round >= 0; --round, j -= 4) {
+        for (int g = 0; g < RC2_GROUPS; ++g) {
+            __m256i* K = k[g];
+            r3[g] = _mm256_and_si256(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(rotr16x8(r3[g], 5, lo16), K[j]),
+                                     _mm256_and_si256(r2[g], r1[g])), _mm256_andnot_si256(r2[g], r0[g])), lo16);
+            r2[g] = _mm256_and_si256(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(rotr16x8(r2[g], 3, lo16), K[j - 1]),
+                                     _mm256_and_si256(r1[g], r0[g])), _mm256_andnot_si256(r1[g], r3[g])), lo16);
+            r1[g] = _mm256_and_si256(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(rotr16x8(r1[g], 2, lo16), K[j - 2]),
+                                     _mm256_and_si256(r0[g], r3[g])), _mm256_andnot_si256(r0[g], r2[g])), lo16);
+            r0[g] = _mm256_and_si256(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(rotr16x8(r0[g], 1, lo16), K[j - 3]),
+                                     _mm256_and_si256(r3[g], r2[g])), _mm256_andnot_si256(r3[g], r1[g])), lo16);
+        }
+        if (round == 11 || round == 5) {
+            for (int g = 0; g < RC2_GROUPS; ++g) {
+#define RC2_MASH_INDEX(r) _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256((r), k_mask), 3), lane)
+                r3[g] = _mm256_and_si256(_mm256_sub_epi32(r3[g], _mm256_i32gather_epi32(ktab[g], RC2_MASH_INDEX(r2[g]), 4)), lo16);
+                r2[g] = _mm256_and_si256(_mm256_sub_epi32(r2[g], _mm256_i32gather_epi32(ktab[g], RC2_MASH_INDEX(r1[g]), 4)), lo16);
+                r1[g] = _mm256_and_si256(_mm256_sub_epi32(r1[g], _mm256_i32gather_epi32(ktab[g], RC2_MASH_INDEX(r0[g]), 4)), lo16);
+                r0[g] = _mm256_and_si256(_mm256_sub_epi32(r0[g], _mm256_i32gather_epi32(ktab[g], RC2_MASH_INDEX(r3[g]), 4)), lo16);
+#undef RC2_MASH_INDEX
+            }
+        }
+    }
+
+    unsigned int mask = 0;
+    for (int g = 0; g < RC2_GROUPS; ++g) {
+        __m256i ok = _mm256_and_si256(_mm256_and_si256(printable16x8(r0[g]), printable16x8(r1[g])),
+                                      _mm256_and_si256(printable16x8(r2[g]), printable16x8(r3[g])));
+        mask |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(ok)) << (8 * g);
+    }
+    return count < 32 ? mask & ((1u << count) - 1) : mask;
+}
+#endif
+
+static _Atomic bool force_scalar = false;
+
+void rc2_force_scalar(bool on) {
+    atomic_store_explicit(&force_scalar, on, memory_order_relaxed);
+}
+
+static bool use_avx2(void) {
+#ifdef RC2_HAVE_AVX2
+    return !atomic_load_explicit(&force_scalar, memory_order_relaxed) && __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+unsigned int rc2_block0_printable(const unsigned char* keys, unsigned int key_len, unsigned int count,
+                                  const unsigned char in[RC2_BLOCK]) {
+    if (count > RC2_LANES) count = RC2_LANES;
+    if (key_len == 0 || key_len > RC2_MAX_KEY_LEN || count == 0) return 0;
+#ifdef RC2_HAVE_AVX2
+    if (use_avx2()) return block0_printable_avx2(keys, key_len, count, in);
+#endif
+    return block0_printable_scalar(keys, key_len, count, in);
+}
+
+const char* rc2_kernel_name(void) {
+    return use_avx2() ? "avx2" : "scalar";
+}
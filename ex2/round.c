@@ -0,0 +1,119 @@
+#include "round.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+static void epoch_wait(round_state_t* rs, uint32_t seen) {
+    // Returns at once if the epoch is no longer `seen`; spurious wakeups are fine.
+    syscall(SYS_futex, (uint32_t*)&rs->epoch, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+}
+
+static void epoch_wake_all(round_state_t* rs) {
+    syscall(SYS_futex, (uint32_t*)&rs->epoch, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+bool round_state_init(round_state_t* rs, int readers) {
+    memset(rs, 0, sizeof(*rs));
+    atomic_init(&rs->epoch, ROUND_EPOCH(0, 0));
+    atomic_init(&rs->current, NULL);
+    rs->readers = readers;
+    rs->hazards = calloc((size_t)readers, sizeof(*rs->hazards));
+    if (!rs->hazards) {
+        fprintf(stderr, "[ERROR] Out of memory for %d round readers\n", readers);
+        return false;
+    }
+    for (int i = 0; i < readers; ++i)
+        atomic_init(&rs->hazards[i], NULL);
+    return true;
+}
+
+static void round_data_free(round_data_t* rd) {
+    keyspace_destroy(rd->keyspace);
+    free(rd);
+}
+
+void round_state_free(round_state_t* rs) {
+    round_data_t* rd = atomic_load(&rs->current);
+    if (rd) round_data_free(rd);
+    while (rs->retired) {
+        rd = rs->retired;
+        rs->retired = rd->retired_next;
+        round_data_free(rd);
+    }
+    free(rs->hazards);
+    rs->hazards = NULL;
+}
+
+round_data_t* round_data_new(unsigned int round, const char* encrypted, unsigned int encrypted_len,
+                             unsigned int key_len, keyspace_t* keyspace) {
+    round_data_t* rd = malloc(sizeof(*rd) + encrypted_len);
+    if (!rd) return NULL;
+    rd->round = round;
+    rd->key_len = key_len;
+    rd->keyspace = keyspace;
+    rd->retired_next = NULL;
+    rd->encrypted_len = encrypted_len;
+    memcpy(rd->encrypted, encrypted, encrypted_len);
+    return rd;
+}
+
+static bool hazard_held(round_state_t* rs, const round_data_t* rd) {
+    for (int i = 0; i < rs->readers; ++i)
+        if (atomic_load(&rs->hazards[i]) == rd) return true;
+    return false;
+}
+
+void round_publish(round_state_t* rs, round_data_t* rd) {
+    // The pointer goes first: a reader that sees the new epoch finds this round (or a later one).
+    round_data_t* old = atomic_exchange(&rs->current, rd);
+    atomic_store_explicit(&rs->epoch, ROUND_EPOCH(rd->round, 0), memory_order_release);
+    epoch_wake_all(rs);
+
+    if (old) {
+        old->retired_next = rs->retired;
+        rs->retired = old;
+    }
+    // Free what no reader holds any more; the rest waits for a later round.
+    round_data_t** link = &rs->retired;
+    while (*link) {
+        round_data_t* r = *link;
+        if (hazard_held(rs, r)) {
+            link = &r->retired_next;
+        } else {
+            *link = r->retired_next;
+            round_data_free(r);
+        }
+    }
+}
+
+bool round_mark_solved(round_state_t* rs, unsigned int round) {
+    if (atomic_load_explicit(&rs->epoch, memory_order_relaxed) != ROUND_EPOCH(round, 0)) return false;
+    atomic_store_explicit(&rs->epoch, ROUND_EPOCH(round, 1), memory_order_release);
+    return true;
+}
+
+round_data_t* round_acquire(round_state_t* rs, int reader, unsigned int last_round) {
+    for (;;) {
+        uint32_t epoch = round_epoch(rs);
+        if (epoch >> 1 != last_round) {
+            // Hazard pointer: announce the round, then make sure it is still current
+            // (and so not retired before the encrypter could see the announcement).
+            round_data_t* rd;
+            do {
+                rd = atomic_load(&rs->current);
+                atomic_store(&rs->hazards[reader], rd);
+            } while (rd != atomic_load(&rs->current));
+            if (rd && rd->round != last_round) return rd;
+            atomic_store(&rs->hazards[reader], NULL);
+        }
+        epoch_wait(rs, epoch);
+    }
+}
+
+void round_release(round_state_t* rs, int reader) {
+    atomic_store_explicit(&rs->hazards[reader], NULL, memory_order_release);
+}
@@ -0,0 +1,75 @@
+#ifndef ROUND_H
+#define ROUND_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "keyspace.h"
+
+// Round state the decrypter threads read without locking.
+//
+// The round number and whether it is solved live in one atomic word, the
+// epoch (round << 1 | solved), so "is my round still open?" is a single
+// acquire load instead of a trip through the shared mutex. The epoch is
+// only written with that mutex held (by the encrypter starting a round and
+// by the thread whose solution is accepted), so solution checks under the
+// mutex see it consistently.
+//
+// Each round's ciphertext (and its keyspace) is an immutable round_data_t
+// published by swapping one pointer, RCU style: readers use it in place
+// for the whole round. A reader protects the round it is working on with a
+// hazard pointer in its own slot; the encrypter keeps replaced rounds on a
+// retired list and frees one only when no slot points at it any more.
+// Threads waiting for the next round sleep on the epoch with a futex.
+
+typedef struct round_data {
+    unsigned int round;
+    unsigned int key_len;
+    keyspace_t* keyspace;  // NULL in random mode; freed with the round
+    struct round_data* retired_next;
+    unsigned int encrypted_len;
+    char encrypted[];
+} round_data_t;
+
+typedef struct {
+    _Atomic uint32_t epoch;  // round << 1 | solved
+    _Atomic(round_data_t*) current;
+    _Atomic(round_data_t*)* hazards;  // one slot per reader
+    int readers;
+    round_data_t* retired;  // encrypter only
+} round_state_t;
+
+#define ROUND_EPOCH(round, solved) ((uint32_t)(round) << 1 | (uint32_t)(solved))
+
+// False (with a message on stderr) if out of memory.
+bool round_state_init(round_state_t* rs, int readers);
+void round_state_free(round_state_t* rs);
+
+// A round to publish: copies the ciphertext and takes over the keyspace.
+round_data_t* round_data_new(unsigned int round, const char* encrypted, unsigned int encrypted_len,
+                             unsigned int key_len, keyspace_t* keyspace);
+
+// Makes `rd` the current round, open, and wakes the waiting readers; the
+// round it replaces is freed as soon as no reader holds it. Call with the
+// submission mutex held.
+void round_publish(round_state_t* rs, round_data_t* rd);
+
+// Marks `round` solved if it is still the current one (call with the
+// submission mutex held). Returns false if it isn't.
+bool round_mark_solved(round_state_t* rs, unsigned int round);
+
+static inline uint32_t round_epoch(round_state_t* rs) {
+    return atomic_load_explicit(&rs->epoch, memory_order_acquire);
+}
+
+// True while `round` is the current round and not solved yet.
+static inline bool round_is_open(round_state_t* rs, unsigned int round) {
+    return round_epoch(rs) == ROUND_EPOCH(round, 0);
+}
+
+// Reader `reader` waits for a round newer than `last_round` and returns it,
+// protected until round_release(). Never returns NULL.
+round_data_t* round_acquire(round_state_t* rs, int reader, unsigned int last_round);
+void round_release(round_state_t* rs, int reader);
+
+#endif // ROUND_H
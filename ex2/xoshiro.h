@@ -0,0 +1,53 @@
+#ifndef XOSHIRO_H
+#define XOSHIRO_H
+
+#include <stdint.h>
+#include <string.h>
+
+// xoshiro256** (Blackman & Vigna): the decrypters' per-thread generator for
+// random-mode guesses. MTA_get_rand_data reseeds from the clock on every
+// call; this is a few cycles per 8 bytes with no shared state, seeded once
+// per thread from MTA_get_rand_data. Not for anything secret, only guesses.
+
+typedef struct {
+    uint64_t s[4];
+} xoshiro_t;
+
+static inline uint64_t xoshiro_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t xoshiro_next(xoshiro_t* x) {
+    uint64_t* s = x->s;
+    uint64_t result = xoshiro_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = xoshiro_rotl(s[3], 45);
+    return result;
+}
+
+// Seeds from 32 bytes; an all-zero seed (the one state it can't leave) is replaced.
+static inline void xoshiro_seed(xoshiro_t* x, const unsigned char seed[32]) {
+    memcpy(x->s, seed, sizeof(x->s));
+    if (!(x->s[0] | x->s[1] | x->s[2] | x->s[3]))
+        x->s[0] = 0x9e3779b97f4a7c15ULL;
+}
+
+// Fills buf with len random bytes.
+static inline void xoshiro_fill(xoshiro_t* x, unsigned char* buf, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t r = xoshiro_next(x);
+        memcpy(buf + i, &r, 8);
+    }
+    if (i < len) {
+        uint64_t r = xoshiro_next(x);
+        memcpy(buf + i, &r, len - i);
+    }
+}
+
+#endif // XOSHIRO_H
@@ -12,6 +12,7 @@
 #include <stdarg.h>
 #include "mta_crypt.h"
 #include "mta_rand.h"
+#include "candidate.h"
 
 #define PIPE_DIR "/mnt/mta/"
 #define ENCRYPTER_PIPE "/mnt/mta/server_pipe"
@@ -34,13 +35,6 @@ void print_str(FILE* out, const char* buf, unsigned int len) {
         fprintf(out, "%c", isprint((unsigned char)buf[i]) ? buf[i] : '.');
 }
 
-int is_printable_str(const char* buf, unsigned int len) {
-    for (unsigned int i = 0; i < len; ++i)
-        if (!isprint((unsigned char)buf[i]))
-            return 0;
-    return 1;
-}
-
 void log_printf(const char *format, ...) {
     va_list args;
     va_start(args, format);
@@ -111,6 +105,9 @@ int main() {
     unsigned long iterations = 0;
     int have_password = 0;
     int first_password = 1;
+    // One cipher context, rekeyed for every guess (set up again if the key length changes)
+    candidate_engine_t engine;
+    unsigned int engine_key_len = 0;
 
     while (1) {
         if (!have_password) {
@@ -132,43 +129,55 @@ int main() {
             }
         }
 
-        // Try to brute-force decrypt
+        if (engine_key_len != key_len) {
+            if (engine_key_len)
+                candidate_free(&engine);
+            if (!candidate_init(&engine, key_len)) {
+                log_printf("%ld  [CLIENT #%d]  [ERROR] Failed to set up the cipher\n", get_timestamp(), my_id);
+                exit(EXIT_FAILURE);
+            }
+            engine_key_len = key_len;
+        }
+
+        // Try to brute-force decrypt, CANDIDATE_BATCH guesses at a time: the
+        // block-0 screen rejects nearly all of them (see candidate.h)
+        unsigned char keys[CANDIDATE_BATCH * (MAX_MSG / 8)];
+        char decrypted[MAX_MSG];
         while (have_password) {
-            iterations++;
-            char* guess_key = malloc(key_len);
-            char* decrypted = malloc(password_len);
-            unsigned int decrypted_len = 0;
-
-            MTA_get_rand_data(guess_key, key_len);
-
-            if (MTA_decrypt(guess_key, key_len, encrypted, password_len, decrypted, &decrypted_len) == MTA_CRYPT_RET_OK) {
-                if (decrypted_len == password_len && is_printable_str(decrypted, decrypted_len)) {
-                    log_printf("%ld  [CLIENT #%d]  [INFO] Decrypted password: ", get_timestamp(), my_id);
-                    print_str(log_file, decrypted, decrypted_len);
-                    log_printf(", Key: ");
-                    print_str(log_file, guess_key, key_len);
-                    log_printf(" (in %lu iterations)\n", iterations);
-
-                    // Send solution to server via server_pipe
-                    int sol_fd = open(ENCRYPTER_PIPE, O_WRONLY | O_NONBLOCK);
-                    if (sol_fd >= 0) {
-                        char solution_msg[MAX_MSG + 32];
-                        int len = snprintf(solution_msg, sizeof(solution_msg), "SOLUTION:%d:", my_id);
-                        memcpy(solution_msg + strlen(solution_msg), decrypted, decrypted_len);
-                        len = strlen(solution_msg) + decrypted_len;
-                        solution_msg[len++] = '\n';
-                        write(sol_fd, solution_msg, len);
-                        close(sol_fd);
-                    }
-                    have_password = 0;
-                    break;
+            MTA_get_rand_data((char*)keys, CANDIDATE_BATCH * key_len);
+            unsigned int hits = candidate_screen(&engine, keys, CANDIDATE_BATCH, (unsigned char*)encrypted);
+            for (unsigned int i = 0; hits; ++i, hits >>= 1) {
+                char* guess_key = (char*)keys + i * key_len;
+                unsigned int decrypted_len = password_len;
+                if (!(hits & 1) || !candidate_test(&engine, (unsigned char*)guess_key, (unsigned char*)encrypted,
+                                                   password_len, (unsigned char*)decrypted))
+                    continue;
+                log_printf("%ld  [CLIENT #%d]  [INFO] Decrypted password: ", get_timestamp(), my_id);
+                print_str(log_file, decrypted, decrypted_len);
+                log_printf(", Key: ");
+                print_str(log_file, guess_key, key_len);
+                log_printf(" (in %lu iterations)\n", iterations + i + 1);
+
+                // Send solution to server via server_pipe
+                int sol_fd = open(ENCRYPTER_PIPE, O_WRONLY | O_NONBLOCK);
+                if (sol_fd >= 0) {
+                    char solution_msg[MAX_MSG + 32];
+                    int len = snprintf(solution_msg, sizeof(solution_msg), "SOLUTION:%d:", my_id);
+                    memcpy(solution_msg + strlen(solution_msg), decrypted, decrypted_len);
+                    len = strlen(solution_msg) + decrypted_len;
+                    solution_msg[len++] = '\n';
+                    write(sol_fd, solution_msg, len);
+                    close(sol_fd);
                 }
+                have_password = 0;
+                break;
             }
-            free(guess_key);
-            free(decrypted);
+            iterations += CANDIDATE_BATCH;
+            if (!have_password)
+                break;
 
-            // Every 1000 iterations, check for new password (non-blocking)
-            if (iterations % 1000 == 0) {
+            // Every 1024 iterations, check for new password (non-blocking)
+            if (iterations % 1024 == 0) {
                 char new_encrypted[MAX_MSG];
                 ssize_t new_n = read(fd, new_encrypted, sizeof(new_encrypted));
                 if (new_n > 0 && (new_n != password_len || memcmp(new_encrypted, encrypted, password_len) != 0)) {
@@ -0,0 +1,46 @@
+#ifndef RC2_H
+#define RC2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// RC2 (RFC 2268) in ECB mode, as MTA_encrypt / MTA_decrypt use it through
+// OpenSSL: the key is the guessed bytes as they are, with 128 effective
+// key bits whatever its length.
+//
+// The multi-key kernel is for testing guesses: it takes RC2_LANES keys at
+// once and reports which of them decrypt one block to printable text. Key
+// expansion is 256 table lookups in two dependent chains per key, which is
+// where the time goes; the AVX2 version runs 16 keys side by side in 32-bit
+// lanes (two vectors of 8, so the gathers of one hide the latency of the
+// other) with the table lookups done as gathers. It is picked at run time
+// when the CPU supports AVX2; otherwise the keys go through the scalar code
+// one by one.
+
+#define RC2_BLOCK 8
+#define RC2_LANES 16
+#define RC2_MAX_KEY_LEN 128
+
+typedef struct {
+    uint16_t k[64];
+} rc2_key_t;
+
+void rc2_set_key(rc2_key_t* ks, const unsigned char* key, unsigned int key_len);
+// `len` bytes of whole blocks; `in` and `out` may be the same buffer.
+void rc2_encrypt(const rc2_key_t* ks, const unsigned char* in, unsigned char* out, size_t len);
+void rc2_decrypt(const rc2_key_t* ks, const unsigned char* in, unsigned char* out, size_t len);
+
+// Decrypts the block `in` under each of `count` keys (count <= RC2_LANES,
+// the keys stored back to back, key_len bytes each) and returns a bitmask
+// with bit i set if key i gives 8 printable bytes (' ' .. '~').
+unsigned int rc2_block0_printable(const unsigned char* keys, unsigned int key_len, unsigned int count,
+                                  const unsigned char in[RC2_BLOCK]);
+
+// "avx2" or "scalar": the kernel rc2_block0_printable() runs.
+const char* rc2_kernel_name(void);
+// Makes rc2_block0_printable() use the scalar kernel even where AVX2 is
+// available, to check one against the other (check_rc2.c).
+void rc2_force_scalar(bool on);
+
+#endif // RC2_H